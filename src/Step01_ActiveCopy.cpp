@@ -0,0 +1,6 @@
+#include "Panzer_ExplicitTemplateInstantiation.hpp"
+
+#include "Step01_ActiveCopy.hpp"
+#include "Step01_ActiveCopy_impl.hpp"
+
+PANZER_INSTANTIATE_TEMPLATE_CLASS_TWO_T(user_app::ActiveCopy)
@@ -0,0 +1,44 @@
+#ifndef __Step01_ActiveCopy_hpp__
+#define __Step01_ActiveCopy_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+#include "Phalanx_MDField.hpp"
+
+namespace user_app {
+
+/** The <code>ScalarT</code> version of a passive (<code>double</code>) field of the
+  * same name and layout.
+  *
+  * Passive closure models evaluate <code>double</code> fields. The evaluators of this
+  * application read those directly, but evaluators that expect a
+  * <code>ScalarT</code> field (e.g. panzer::Integrator_BasisTimesScalar) are served
+  * by this copy. Phalanx drops it from the graph when nothing asks for the
+  * <code>ScalarT</code> field. It must not be registered when <code>ScalarT</code>
+  * is <code>double</code>: the two fields are then one and the same.
+  */
+template<typename EvalT, typename Traits>
+class ActiveCopy : public PHX::EvaluatorWithBaseImpl<Traits>,
+                   public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    ActiveCopy(const std::string & name,
+               const Teuchos::RCP<PHX::DataLayout> & data_layout);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  PHX::MDField<double> passive;
+  PHX::MDField<ScalarT> active;
+};
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __Step01_ActiveCopy_impl_hpp__
+#define __Step01_ActiveCopy_impl_hpp__
+
+#include "Phalanx_DataLayout.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+ActiveCopy<EvalT,Traits>::ActiveCopy(const std::string & name,
+                                     const Teuchos::RCP<PHX::DataLayout> & data_layout)
+{
+  passive = PHX::MDField<double>(name, data_layout);
+  this->addDependentField(passive);
+
+  active = PHX::MDField<ScalarT>(name, data_layout);
+  this->addEvaluatedField(active);
+
+  this->setName("Active Copy("+name+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void ActiveCopy<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                     PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(passive,fm);
+  this->utils.setFieldData(active,fm);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void ActiveCopy<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  // the fields are flat over the (Cell,...) extents of the workset
+  const std::size_t num_entries = passive.size();
+  for (std::size_t i = 0; i < num_entries; ++i)
+    active[i] = passive[i];
+}
+
+//**********************************************************************
+}
+
+#endif
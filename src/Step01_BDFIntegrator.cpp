@@ -0,0 +1,295 @@
+#include "Step01_BDFIntegrator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Teuchos_Assert.hpp"
+
+#include "Thyra_LinearOpWithSolveFactoryHelpers.hpp"
+#include "Thyra_VectorStdOps.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+BDFIntegrator::
+BDFIntegrator(const Teuchos::RCP<const Thyra::ModelEvaluator<double> > & model,
+              const Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > & lowsFactory,
+              int order)
+  : model_(model)
+  , lowsFactory_(lowsFactory)
+  , order_(order)
+  , tolerance_(1.0e-8)
+  , max_iterations_(10)
+  , reuse_ratio_(1.0)
+  , error_control_(false)
+  , t_(0.0)
+  , dt_old_(0.0)
+  , dt_old2_(0.0)
+  , num_history_(0)
+  , t_new_(0.0)
+  , dt_new_(0.0)
+  , step_order_(0)
+  , num_steps_(0)
+  , num_solver_builds_(0)
+  , num_newton_iterations_(0)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(order_!=1 && order_!=2,std::logic_error,
+                             "BDFIntegrator: order " << order_ << " is not supported, choose 1 or 2.");
+
+  x_       = Thyra::createMember(model_->get_x_space());
+  x_old_   = Thyra::createMember(model_->get_x_space());
+  x_old2_  = Thyra::createMember(model_->get_x_space());
+  x_new_   = Thyra::createMember(model_->get_x_space());
+  x_pred_  = Thyra::createMember(model_->get_x_space());
+  x_dot_   = Thyra::createMember(model_->get_x_space());
+  history_ = Thyra::createMember(model_->get_x_space());
+  delta_   = Thyra::createMember(model_->get_x_space());
+  f_       = Thyra::createMember(model_->get_f_space());
+  Thyra::assign(x_.ptr(),0.0);
+}
+
+//**********************************************************************
+void BDFIntegrator::
+setNewtonTolerance(double tolerance,int maxIterations)
+{
+  tolerance_ = tolerance;
+  max_iterations_ = maxIterations;
+}
+
+//**********************************************************************
+void BDFIntegrator::
+setSolverReuseRatio(double ratio)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(ratio<1.0,std::logic_error,
+                             "BDFIntegrator: the solver reuse ratio " << ratio << " is below 1!");
+  reuse_ratio_ = ratio;
+}
+
+//**********************************************************************
+void BDFIntegrator::
+setErrorControl(bool errorControl)
+{
+  error_control_ = errorControl;
+}
+
+//**********************************************************************
+void BDFIntegrator::
+initialize(const Thyra::VectorBase<double> & x,double t)
+{
+  Thyra::assign(x_.ptr(),x);
+  t_ = t;
+  dt_old_ = 0.0;
+  dt_old2_ = 0.0;
+  num_history_ = 0;
+  step_order_ = 0;
+}
+
+//**********************************************************************
+void BDFIntegrator::
+step(double dt)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(!solveStep(dt),std::runtime_error,
+                             "BDFIntegrator: Newton did not converge in " << max_iterations_ << " iterations "
+                             "at t = " << t_new_ << ", ||f|| = " << Thyra::norm_2(*f_));
+  acceptStep();
+}
+
+//**********************************************************************
+bool BDFIntegrator::
+solveStep(double dt)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(dt<=0.0,std::logic_error,"BDFIntegrator: the step " << dt << " is not positive!");
+
+  t_new_ = t_+dt;
+  dt_new_ = dt;
+  step_order_ = (order_==2 && num_history_>=(error_control_ ? 2 : 1)) ? 2 : 1;
+
+  // x_dot = alpha x_{n+1} + history
+  double alpha = 0.0;
+  if(step_order_==2) {
+    // variable step BDF2, w = dt_n/dt_{n-1}:
+    //   dt x_dot = (1+2w)/(1+w) x_{n+1} - (1+w) x_n + w^2/(1+w) x_{n-1}
+    const double w = dt/dt_old_;
+    alpha = (1.0+2.0*w)/((1.0+w)*dt);
+    Thyra::V_StVpStV(history_.ptr(),-(1.0+w)/dt,*x_,w*w/((1.0+w)*dt),*x_old_);
+  }
+  else {
+    alpha = 1.0/dt;
+    Thyra::V_StV(history_.ptr(),-1.0/dt,*x_);
+  }
+
+  // predictor: extrapolate the polynomial through the last step_order+1 solutions,
+  // or as many as there are
+  const double h = dt, h1 = dt_old_, h2 = dt_old2_;
+  if(num_history_>=2 && step_order_==2) {
+    const double l0 = (h+h1)*(h+h1+h2)/(h1*(h1+h2));
+    const double l1 = -h*(h+h1+h2)/(h1*h2);
+    const double l2 = h*(h+h1)/((h1+h2)*h2);
+    Thyra::V_StVpStV(x_pred_.ptr(),l0,*x_,l1,*x_old_);
+    Thyra::Vp_StV(x_pred_.ptr(),l2,*x_old2_);
+  }
+  else if(num_history_>=1)
+    Thyra::V_StVpStV(x_pred_.ptr(),1.0+h/h1,*x_,-h/h1,*x_old_);
+  else
+    Thyra::assign(x_pred_.ptr(),*x_);
+  Thyra::assign(x_new_.ptr(),*x_pred_);
+
+  // chord iterations on a stored W, rebuilt only when they stall
+  Solver * solver = findSolver(alpha);
+  double f_norm_old = -1.0;
+  for(int iteration=0;;iteration++) {
+    const double f_norm = evalResidual(alpha);
+    if(f_norm<=tolerance_)
+      break;
+    if(iteration>=max_iterations_)
+      return false;
+
+    if(solver==0) {
+      solver = &newSolver();
+      buildSolver(alpha,*solver);
+    }
+    else if(f_norm_old>0.0 && f_norm>0.5*f_norm_old)
+      buildSolver(alpha,*solver);
+    solver->last_used = num_steps_;
+
+    Thyra::assign(delta_.ptr(),0.0);
+    solver->lows->solve(Thyra::NOTRANS,*f_,delta_.ptr());
+    Thyra::Vp_StV(x_new_.ptr(),-1.0,*delta_);
+
+    f_norm_old = f_norm;
+    num_newton_iterations_++;
+  }
+
+  return true;
+}
+
+//**********************************************************************
+double BDFIntegrator::
+errorEstimate(double absTolerance,double relTolerance)
+{
+  if(num_history_<step_order_)
+    return -1.0;
+
+  // with x''' (x'' for BDF1) locally constant, x_new - x = c A and x_pred - x = -c B
+  const double h = dt_new_, h1 = dt_old_, h2 = dt_old2_;
+  double A = 0.0, B = 0.0;
+  if(step_order_==2) {
+    A = h*h*(h+h1)*(h+h1)/(2.0*h+h1);
+    B = h*(h+h1)*(h+h1+h2);
+  }
+  else {
+    A = h*h;
+    B = h*(h+h1);
+  }
+
+  // e = A/(A+B) (x_new - x_pred), weighted by a + r|x_new|; the Newton work
+  // vectors are free once the step is solved
+  Thyra::V_VmV(delta_.ptr(),*x_new_,*x_pred_);
+  Thyra::abs(*x_new_,history_.ptr());
+  Thyra::Vt_S(history_.ptr(),relTolerance);
+  Thyra::Vp_S(history_.ptr(),absTolerance);
+  Thyra::ele_wise_divide(A/(A+B),*delta_,*history_,x_dot_.ptr());
+
+  return Thyra::norm_2(*x_dot_)/std::sqrt(double(model_->get_x_space()->dim()));
+}
+
+//**********************************************************************
+void BDFIntegrator::
+acceptStep()
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(step_order_==0,std::logic_error,"BDFIntegrator: there is no solved step to accept!");
+
+  // x_{n-2} <- x_{n-1} <- x_n <- x_{n+1}, the oldest buffer takes the next iterate
+  Teuchos::RCP<Thyra::VectorBase<double> > tmp = x_old2_;
+  x_old2_ = x_old_;
+  x_old_ = x_;
+  x_ = x_new_;
+  x_new_ = tmp;
+
+  t_ = t_new_;
+  dt_old2_ = dt_old_;
+  dt_old_ = dt_new_;
+  num_history_ = std::min(num_history_+1,2);
+  step_order_ = 0;
+  num_steps_++;
+}
+
+//**********************************************************************
+BDFIntegrator::Solver * BDFIntegrator::
+findSolver(double alpha)
+{
+  Solver * best = 0;
+  double best_ratio = reuse_ratio_;
+  for(std::size_t i=0;i<solvers_.size();i++) {
+    const double ratio = std::max(alpha/solvers_[i].alpha,solvers_[i].alpha/alpha);
+    if(ratio<=best_ratio) {
+      best = &solvers_[i];
+      best_ratio = ratio;
+    }
+  }
+  return best;
+}
+
+//**********************************************************************
+BDFIntegrator::Solver & BDFIntegrator::
+newSolver()
+{
+  if(solvers_.size()<2) {
+    Solver solver;
+    solver.alpha = 0.0;
+    solver.last_used = num_steps_;
+    solver.W_op = model_->create_W_op();
+    solver.lows = lowsFactory_->createOp();
+    solvers_.push_back(solver);
+    return solvers_.back();
+  }
+
+  std::size_t oldest = 0;
+  for(std::size_t i=1;i<solvers_.size();i++)
+    if(solvers_[i].last_used<solvers_[oldest].last_used)
+      oldest = i;
+  return solvers_[oldest];
+}
+
+//**********************************************************************
+void BDFIntegrator::
+buildSolver(double alpha,Solver & solver)
+{
+  Thyra::ModelEvaluatorBase::InArgs<double> inArgs = model_->createInArgs();
+  inArgs.set_x(x_new_);
+  inArgs.set_x_dot(x_dot_);
+  inArgs.set_t(t_new_);
+  inArgs.set_alpha(alpha);
+  inArgs.set_beta(1.0);
+
+  Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = model_->createOutArgs();
+  outArgs.set_W_op(solver.W_op);
+
+  model_->evalModel(inArgs,outArgs);
+
+  // the factorization or preconditioner is computed here, and only here
+  Thyra::initializeOp<double>(*lowsFactory_,solver.W_op,solver.lows.ptr());
+  solver.alpha = alpha;
+  num_solver_builds_++;
+}
+
+//**********************************************************************
+double BDFIntegrator::
+evalResidual(double alpha)
+{
+  Thyra::V_StVpV(x_dot_.ptr(),alpha,*x_new_,*history_);
+
+  Thyra::ModelEvaluatorBase::InArgs<double> inArgs = model_->createInArgs();
+  inArgs.set_x(x_new_);
+  inArgs.set_x_dot(x_dot_);
+  inArgs.set_t(t_new_);
+
+  Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = model_->createOutArgs();
+  outArgs.set_f(f_);
+
+  model_->evalModel(inArgs,outArgs);
+
+  return Thyra::norm_2(*f_);
+}
+
+}
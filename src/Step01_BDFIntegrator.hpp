@@ -0,0 +1,153 @@
+#ifndef __Step01_BDFIntegrator_hpp__
+#define __Step01_BDFIntegrator_hpp__
+
+#include <vector>
+
+#include "Teuchos_RCP.hpp"
+
+#include "Thyra_LinearOpWithSolveBase.hpp"
+#include "Thyra_LinearOpWithSolveFactoryBase.hpp"
+#include "Thyra_ModelEvaluator.hpp"
+
+namespace user_app {
+
+/** Implicit BDF1/BDF2 time stepping of a transient model evaluator,
+  * \f$ f(\dot{x}, x, t) = M \dot{x} + K x - F(t) \f$.
+  *
+  * Every step solves \f$ f(\alpha x_{n+1} + h, x_{n+1}, t_{n+1}) = 0 \f$, with
+  * \f$ \alpha \f$ and the history \f$ h \f$ given by the BDF formula, by Newton
+  * iterations on \f$ W = \alpha M + \partial f/\partial x \f$. W and its
+  * solver (factorization or preconditioner) are built once per
+  * \f$ \alpha \f$ and then reused, i.e. the iterations are chord iterations:
+  * for a linear model with a fixed step every step costs one solve with the
+  * first factorization and two residual assemblies, one at the predictor and
+  * one after the update to confirm convergence. W is only rebuilt at
+  * the current iterate when the chord iteration stalls on a nonlinear model.
+  * With a reuse ratio above one a W is also kept for steps whose
+  * \f$ \alpha \f$ (which scales as 1/dt) is within that ratio of its own.
+  *
+  * BDF2 uses the variable step formula, so the steps need not be equal; the
+  * first step after initialize() is BDF1. A step is solved by solveStep() and
+  * kept by acceptStep(), so that a step control can reject it in between
+  * based on errorEstimate().
+  */
+class BDFIntegrator {
+public:
+
+  BDFIntegrator(const Teuchos::RCP<const Thyra::ModelEvaluator<double> > & model,
+                const Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > & lowsFactory,
+                int order);
+
+  /** Newton stops once \f$ \|f\|_2 \f$ is at most <code>tolerance</code>, and fails
+    * after <code>maxIterations</code> iterations.
+    */
+  void setNewtonTolerance(double tolerance,int maxIterations);
+
+  /** Reuse a W built for \f$ \alpha' \f$ at \f$ \alpha \f$ when
+    * \f$ \max(\alpha/\alpha',\alpha'/\alpha) \f$ is at most <code>ratio</code>;
+    * 1 (the default) builds a W for every distinct \f$ \alpha \f$.
+    */
+  void setSolverReuseRatio(double ratio);
+
+  /** With error control BDF2 waits for enough history to estimate the error of
+    * its first step, i.e. the first two steps are BDF1.
+    */
+  void setErrorControl(bool errorControl);
+
+  /** Start from <code>x</code> at time <code>t</code>, forgetting the history.
+    */
+  void initialize(const Thyra::VectorBase<double> & x,double t);
+
+  /** Advance the solution by <code>dt</code>, throws if Newton fails.
+    */
+  void step(double dt);
+
+  /** Solve for the solution at <code>getTime()+dt</code> without keeping it,
+    * returns false if Newton fails.
+    */
+  bool solveStep(double dt);
+
+  /** Weighted RMS norm, \f$ \sqrt{\frac{1}{N}\sum_i (e_i/(a + r|x_i|))^2} \f$, of the
+    * local error estimate \f$ e \f$ of the solved step. The estimate compares the
+    * step with the polynomial extrapolation of the history (Milne's device).
+    * Negative if the history is too short to estimate the error.
+    */
+  double errorEstimate(double absTolerance,double relTolerance);
+
+  //! Order of the solved step
+  int stepOrder() const
+  { return step_order_; }
+
+  /** Keep the solved step.
+    */
+  void acceptStep();
+
+  Teuchos::RCP<const Thyra::VectorBase<double> > getSolution() const
+  { return x_; }
+
+  double getTime() const
+  { return t_; }
+
+  int numSteps() const
+  { return num_steps_; }
+
+  //! Assemblies and factorizations of W so far
+  int numSolverBuilds() const
+  { return num_solver_builds_; }
+
+  int numNewtonIterations() const
+  { return num_newton_iterations_; }
+
+private:
+
+  struct Solver {
+    double alpha;
+    int last_used;
+    Teuchos::RCP<Thyra::LinearOpBase<double> > W_op;
+    Teuchos::RCP<Thyra::LinearOpWithSolveBase<double> > lows;
+  };
+
+  // the stored solver whose alpha is closest to alpha within the reuse ratio, or null
+  Solver * findSolver(double alpha);
+
+  // slot for a new solver, the least recently used one once all are taken
+  Solver & newSolver();
+
+  // assemble W = alpha M + df/dx at the current iterate and (re)initialize its solver
+  void buildSolver(double alpha,Solver & solver);
+
+  // f at the current iterate, x_dot = alpha x_new + history
+  double evalResidual(double alpha);
+
+  Teuchos::RCP<const Thyra::ModelEvaluator<double> > model_;
+  Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory_;
+  int order_;
+
+  double tolerance_;
+  int max_iterations_;
+  double reuse_ratio_;
+  bool error_control_;
+
+  // x_n, x_{n-1} and x_{n-2}, the steps that led to x_n and x_{n-1}, and how many
+  // of the older solutions there are
+  Teuchos::RCP<Thyra::VectorBase<double> > x_, x_old_, x_old2_;
+  double t_, dt_old_, dt_old2_;
+  int num_history_;
+
+  // the solved step: its iterate, predictor, time derivative and residual, the
+  // history term of x_dot
+  Teuchos::RCP<Thyra::VectorBase<double> > x_new_, x_pred_, x_dot_, history_, f_, delta_;
+  double t_new_, dt_new_;
+  int step_order_;
+
+  // a fixed step needs one (BDF1) or two (BDF2) solvers
+  std::vector<Solver> solvers_;
+
+  int num_steps_;
+  int num_solver_builds_;
+  int num_newton_iterations_;
+};
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __Step01_BatchedRealFFT_hpp__
+#define __Step01_BatchedRealFFT_hpp__
+
+#include <vector>
+
+namespace user_app {
+
+/** Radix-2 real FFT applied to a batch of independent signals at once.
+  *
+  * Data is stored "sample major": entry <code>n*batch+b</code> holds sample
+  * <code>n</code> of signal <code>b</code>, so every butterfly is a contiguous,
+  * vectorizable loop over the batch. A length <code>N</code> real transform is
+  * computed with one length <code>N/2</code> complex transform plus a
+  * post-processing pass, so the cost is O(N log N) per signal. The scalar type
+  * is a template parameter so AD types go through the same code.
+  *
+  * Conventions (unnormalized): <code>forward</code> computes
+  * \f$X_k = \sum_n x_n e^{-2\pi i k n/N}\f$ for \f$k=0..N/2\f$, and
+  * <code>inverse</code> computes \f$x_n = \sum_{k=0}^{N-1} X_k e^{2\pi i k n/N}\f$
+  * using the Hermitian symmetry of the half spectrum it is given.
+  */
+template <typename ScalarT>
+class BatchedRealFFT {
+public:
+
+  //! \param[in] n Transform length, a power of two (at least 2)
+  BatchedRealFFT(int n);
+
+  int size() const
+  { return n_; }
+
+  /** \param[in] x Real samples, <code>n*batch</code> entries
+    * \param[out] re,im Half spectrum, <code>(n/2+1)*batch</code> entries each
+    */
+  void forward(const ScalarT * x,ScalarT * re,ScalarT * im,int batch) const;
+
+  /** \param[in] re,im Half spectrum, <code>(n/2+1)*batch</code> entries each
+    * \param[out] x Real samples, <code>n*batch</code> entries
+    */
+  void inverse(const ScalarT * re,const ScalarT * im,ScalarT * x,int batch) const;
+
+private:
+
+  // in place complex transform of length n_/2, sign = -1 forward, +1 inverse
+  void complexTransform(ScalarT * re,ScalarT * im,int batch,int sign) const;
+
+  int n_;
+  std::vector<int> bitReverse_;   // permutation for the length n_/2 transform
+  std::vector<double> cos_, sin_; // cos(2 pi j/n_), sin(2 pi j/n_), j < n_/2
+
+  // scratch for the packed complex signal
+  mutable std::vector<ScalarT> zRe_, zIm_;
+};
+
+}
+
+#include "Step01_BatchedRealFFT_impl.hpp"
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef __Step01_BatchedRealFFT_impl_hpp__
+#define __Step01_BatchedRealFFT_impl_hpp__
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename ScalarT>
+BatchedRealFFT<ScalarT>::BatchedRealFFT(int n)
+  : n_(n)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(n<2 || (n & (n-1))!=0,std::logic_error,
+                             "BatchedRealFFT: length " << n << " is not a power of two!");
+
+  const int h = n_/2;
+
+  int bits = 0;
+  while((1 << bits) < h) bits++;
+
+  bitReverse_.resize(h);
+  for(int i=0;i<h;i++) {
+    int r = 0;
+    for(int b=0;b<bits;b++)
+      if(i & (1 << b)) r |= 1 << (bits-1-b);
+    bitReverse_[i] = r;
+  }
+
+  cos_.resize(h+1);
+  sin_.resize(h+1);
+  for(int j=0;j<=h;j++) {
+    cos_[j] = std::cos(2.0*M_PI*j/n_);
+    sin_[j] = std::sin(2.0*M_PI*j/n_);
+  }
+}
+
+//**********************************************************************
+template <typename ScalarT>
+void BatchedRealFFT<ScalarT>::
+complexTransform(ScalarT * re,ScalarT * im,int batch,int sign) const
+{
+  const int h = n_/2;
+
+  for(int i=0;i<h;i++) {
+    const int j = bitReverse_[i];
+    if(i<j) {
+      std::swap_ranges(re+i*batch,re+(i+1)*batch,re+j*batch);
+      std::swap_ranges(im+i*batch,im+(i+1)*batch,im+j*batch);
+    }
+  }
+
+  for(int len=2;len<=h;len<<=1) {
+    const int half = len/2;
+    const int step = n_/len;
+    for(int i=0;i<h;i+=len) {
+      for(int j=0;j<half;j++) {
+        const double wr = cos_[j*step];
+        const double wi = sign*sin_[j*step];
+
+        ScalarT * ar = re+(i+j)*batch;
+        ScalarT * ai = im+(i+j)*batch;
+        ScalarT * br = re+(i+j+half)*batch;
+        ScalarT * bi = im+(i+j+half)*batch;
+        for(int b=0;b<batch;b++) {
+          const ScalarT tr = br[b]*wr - bi[b]*wi;
+          const ScalarT ti = br[b]*wi + bi[b]*wr;
+          br[b] = ar[b] - tr;
+          bi[b] = ai[b] - ti;
+          ar[b] += tr;
+          ai[b] += ti;
+        }
+      }
+    }
+  }
+}
+
+//**********************************************************************
+template <typename ScalarT>
+void BatchedRealFFT<ScalarT>::
+forward(const ScalarT * x,ScalarT * re,ScalarT * im,int batch) const
+{
+  const int h = n_/2;
+  zRe_.resize(h*batch);
+  zIm_.resize(h*batch);
+
+  // pack the even samples into the real part and the odd samples into the imaginary part
+  for(int m=0;m<h;m++) {
+    const ScalarT * xe = x+(2*m)*batch;
+    const ScalarT * xo = x+(2*m+1)*batch;
+    for(int b=0;b<batch;b++) {
+      zRe_[m*batch+b] = xe[b];
+      zIm_[m*batch+b] = xo[b];
+    }
+  }
+
+  complexTransform(&zRe_[0],&zIm_[0],batch,-1);
+
+  // split into the transforms of the even (E) and odd (O) samples, X_k = E_k + W^k O_k
+  for(int k=0;k<=h;k++) {
+    const ScalarT * zr  = &zRe_[(k%h)*batch];
+    const ScalarT * zi  = &zIm_[(k%h)*batch];
+    const ScalarT * zcr = &zRe_[((h-k)%h)*batch];
+    const ScalarT * zci = &zIm_[((h-k)%h)*batch];
+    const double c = cos_[k];
+    const double s = sin_[k];
+    for(int b=0;b<batch;b++) {
+      const ScalarT er = 0.5*(zr[b] + zcr[b]);
+      const ScalarT ei = 0.5*(zi[b] - zci[b]);
+      const ScalarT or_ = 0.5*(zi[b] + zci[b]);
+      const ScalarT oi = -0.5*(zr[b] - zcr[b]);
+      re[k*batch+b] = er + c*or_ + s*oi;
+      im[k*batch+b] = ei + c*oi - s*or_;
+    }
+  }
+}
+
+//**********************************************************************
+template <typename ScalarT>
+void BatchedRealFFT<ScalarT>::
+inverse(const ScalarT * re,const ScalarT * im,ScalarT * x,int batch) const
+{
+  const int h = n_/2;
+  zRe_.resize(h*batch);
+  zIm_.resize(h*batch);
+
+  // rebuild the packed spectrum Z_k = E_k + i O_k from X_k and conj(X_{h-k})
+  for(int k=0;k<h;k++) {
+    const ScalarT * xr  = re+k*batch;
+    const ScalarT * xi  = im+k*batch;
+    const ScalarT * xcr = re+(h-k)*batch;
+    const ScalarT * xci = im+(h-k)*batch;
+    const double c = cos_[k];
+    const double s = sin_[k];
+    for(int b=0;b<batch;b++) {
+      const ScalarT er = xr[b] + xcr[b];
+      const ScalarT ei = xi[b] - xci[b];
+      const ScalarT dr = xr[b] - xcr[b];
+      const ScalarT di = xi[b] + xci[b];
+      // O = (X_k - conj(X_{h-k})) W^{-k}
+      const ScalarT or_ = c*dr - s*di;
+      const ScalarT oi = c*di + s*dr;
+      zRe_[k*batch+b] = er - oi;
+      zIm_[k*batch+b] = ei + or_;
+    }
+  }
+
+  complexTransform(&zRe_[0],&zIm_[0],batch,+1);
+
+  for(int m=0;m<h;m++) {
+    ScalarT * xe = x+(2*m)*batch;
+    ScalarT * xo = x+(2*m+1)*batch;
+    for(int b=0;b<batch;b++) {
+      xe[b] = zRe_[m*batch+b];
+      xo[b] = zIm_[m*batch+b];
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef __Step01_CellPointPolicy_hpp__
+#define __Step01_CellPointPolicy_hpp__
+
+#include "Kokkos_Core.hpp"
+
+#include "Panzer_Workset.hpp"
+
+namespace user_app {
+
+/** Execution space of the user evaluators. The fields of this application live on
+  * the host, so the loops run on the host space Kokkos was configured with
+  * (OpenMP, Threads or Serial), threaded inside an MPI rank.
+  */
+typedef Kokkos::DefaultHostExecutionSpace CellPointExecutionSpace;
+
+//! A 2D range over the (Cell,Point) entries of a workset
+typedef Kokkos::MDRangePolicy<CellPointExecutionSpace,Kokkos::Rank<2> > CellPointPolicy;
+
+//! The policy for the first <code>num_cells</code> cells and <code>num_points</code> points
+inline CellPointPolicy cellPointPolicy(panzer::index_t num_cells,int num_points)
+{ return CellPointPolicy({0,0},{static_cast<long>(num_cells),static_cast<long>(num_points)}); }
+
+}
+
+#endif
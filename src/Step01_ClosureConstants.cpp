@@ -0,0 +1,40 @@
+#include "Step01_ClosureConstants.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+void addClosureConstants(const Teuchos::ParameterList & closure_models,
+                         Teuchos::ParameterList & user_data)
+{
+  Teuchos::ParameterList & constants = user_data.sublist("Closure Constants");
+
+  for(Teuchos::ParameterList::ConstIterator model=closure_models.begin();model!=closure_models.end();++model) {
+    if(!closure_models.isSublist(model->first))
+      continue;
+
+    const Teuchos::ParameterList & fields = closure_models.sublist(model->first);
+    for(Teuchos::ParameterList::ConstIterator field=fields.begin();field!=fields.end();++field) {
+      if(fields.isSublist(field->first) && fields.sublist(field->first).isType<double>("Value"))
+        constants.sublist(model->first).set(field->first,fields.sublist(field->first).get<double>("Value"));
+    }
+  }
+}
+
+//**********************************************************************
+bool findClosureConstant(const Teuchos::ParameterList & user_data,
+                         const std::string & model_id,
+                         const std::string & field_name,
+                         double & value)
+{
+  if(!user_data.isSublist("Closure Constants"))
+    return false;
+
+  const Teuchos::ParameterList & constants = user_data.sublist("Closure Constants");
+  if(!constants.isSublist(model_id) || !constants.sublist(model_id).isType<double>(field_name))
+    return false;
+
+  value = constants.sublist(model_id).get<double>(field_name);
+  return true;
+}
+
+}
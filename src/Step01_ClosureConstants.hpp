@@ -0,0 +1,29 @@
+#ifndef __Step01_ClosureConstants_hpp__
+#define __Step01_ClosureConstants_hpp__
+
+#include <string>
+
+#include "Teuchos_ParameterList.hpp"
+
+namespace user_app {
+
+/** Record the "Value" closure models of every model in the "Closure Constants"
+  * sublist of the user data, under the model id and the field name.
+  *
+  * The equation sets see the user data, not the closure models. With the constants
+  * at hand they pass a constant source to their residual evaluators as a number,
+  * so the field is neither allocated nor evaluated: Phalanx drops the constant
+  * evaluators nobody depends on.
+  */
+void addClosureConstants(const Teuchos::ParameterList & closure_models,
+                         Teuchos::ParameterList & user_data);
+
+//! The value of a constant closure field, false if the field is not a constant
+bool findClosureConstant(const Teuchos::ParameterList & user_data,
+                         const std::string & model_id,
+                         const std::string & field_name,
+                         double & value);
+
+}
+
+#endif
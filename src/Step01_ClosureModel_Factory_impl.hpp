@@ -46,6 +46,7 @@
 #include <iostream>
 #include <sstream>
 #include <typeinfo>
+#include <type_traits>
 
 #include "Teuchos_ParameterEntry.hpp"
 #include "Teuchos_TypeNameTraits.hpp"
@@ -54,13 +55,16 @@
 #include "Panzer_IntegrationRule.hpp"
 #include "Panzer_BasisIRLayout.hpp"
 
-#include "Panzer_Constant.hpp"
 #include "Panzer_Integrator_Scalar.hpp"
 
 #include "Step01_LinearFunction.hpp"
+#include "Step01_PassiveConstant.hpp"
+#include "Step01_ActiveCopy.hpp"
 
 // begin modication
 #include "Step01_SinXSinYFunction.hpp"
+#include "Step01_ExpressionFunction.hpp"
+#include "Step01_TabulatedFunction.hpp"
 // end modification
 
 // ********************************************************************
@@ -98,6 +102,12 @@ buildClosureModels(const std::string& model_id,
   // for a model id get the parameter list that defines all the models
   const ParameterList& my_models = models.sublist(model_id);
 
+  // The closure models here do not depend on the solution, so they evaluate passive
+  // (double) fields. For evaluation types with a derivative ScalarT a copy of
+  // each field is offered in ScalarT, used only by evaluators that ask for it.
+  const bool add_active_copies = !std::is_same<typename EvalT::ScalarT,double>::value;
+  std::vector<std::pair<std::string,RCP<PHX::DataLayout> > > passive_fields;
+
   // loop over all the models
   for (ParameterList::ConstIterator model_it = my_models.begin(); 
       model_it != my_models.end(); ++model_it) {
@@ -119,8 +129,9 @@ buildClosureModels(const std::string& model_id,
         input.set("Value", plist.get<double>("Value"));
         input.set("Data Layout", ir->dl_scalar);
         RCP<PHX::Evaluator<panzer::Traits> > e =
-              rcp(new panzer::Constant<EvalT,panzer::Traits>(input));
+              rcp(new user_app::PassiveConstant<EvalT,panzer::Traits>(input));
         evaluators->push_back(e);
+        passive_fields.push_back(std::make_pair(key,ir->dl_scalar));
       }
 
       // add constant evaluator for each basis
@@ -131,8 +142,9 @@ buildClosureModels(const std::string& model_id,
         Teuchos::RCP<const panzer::BasisIRLayout> basis = basisIRLayout(*basis_itr,*ir);
         input.set("Data Layout", basis->functional);
         RCP<PHX::Evaluator<panzer::Traits> > e =
-            rcp(new panzer::Constant<EvalT,panzer::Traits>(input));
+            rcp(new user_app::PassiveConstant<EvalT,panzer::Traits>(input));
         evaluators->push_back(e);
+        passive_fields.push_back(std::make_pair(key,basis->functional));
       }
       found = true;
     }
@@ -147,6 +159,7 @@ buildClosureModels(const std::string& model_id,
         RCP<PHX::Evaluator<panzer::Traits> > e =
             rcp(new user_app::LinearFunction<EvalT,panzer::Traits>(key,acoeff,bcoeff,*ir));
         evaluators->push_back(e);
+        passive_fields.push_back(std::make_pair(key,ir->dl_scalar));
 
         found = true;
       }
@@ -160,6 +173,38 @@ buildClosureModels(const std::string& model_id,
         RCP<PHX::Evaluator<panzer::Traits> > e =
 	  rcp(new user_app::SinXSinYFunction<EvalT,panzer::Traits>(key,xperiod,yperiod,*ir));
         evaluators->push_back(e);
+        passive_fields.push_back(std::make_pair(key,ir->dl_scalar));
+
+        found = true;
+      }
+
+      // a formula in x, y, t and the entries of the "Parameters" sublist
+      else if(evaluator_type == "Expression" ) {
+        std::string formula = plist.get<std::string>("Formula");
+
+        std::map<std::string,double> parameters;
+        if(plist.isSublist("Parameters")) {
+          const ParameterList & param_pl = plist.sublist("Parameters");
+          for(ParameterList::ConstIterator itr=param_pl.begin();itr!=param_pl.end();++itr)
+            parameters[itr->first] = param_pl.get<double>(itr->first);
+        }
+
+        RCP<PHX::Evaluator<panzer::Traits> > e =
+          rcp(new user_app::ExpressionFunction<EvalT,panzer::Traits>(key,formula,parameters,*ir));
+        evaluators->push_back(e);
+        passive_fields.push_back(std::make_pair(key,ir->dl_scalar));
+
+        found = true;
+      }
+
+      // measured data, interpolated from a grid or from scattered points
+      else if(evaluator_type == "Tabulated" ) {
+        std::string file_name = plist.get<std::string>("File");
+
+        RCP<PHX::Evaluator<panzer::Traits> > e =
+          rcp(new user_app::TabulatedFunction<EvalT,panzer::Traits>(key,user_app::TabulatedData::open(file_name),*ir));
+        evaluators->push_back(e);
+        passive_fields.push_back(std::make_pair(key,ir->dl_scalar));
 
         found = true;
       }
@@ -177,6 +222,14 @@ buildClosureModels(const std::string& model_id,
 
   } // end loop over models in parameter list
 
+  if(add_active_copies) {
+    for(std::size_t i=0;i<passive_fields.size();i++) {
+      RCP<PHX::Evaluator<panzer::Traits> > e =
+          rcp(new user_app::ActiveCopy<EvalT,panzer::Traits>(passive_fields[i].first,passive_fields[i].second));
+      evaluators->push_back(e);
+    }
+  }
+
   return evaluators;
 }
 
@@ -0,0 +1,360 @@
+#include "Step01_CompiledExpression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+CompiledExpression::
+CompiledExpression(const std::string & formula,
+                   const std::vector<std::string> & variable_names,
+                   const std::map<std::string,double> & parameters)
+  : formula_(formula)
+  , variable_names_(variable_names)
+  , parameters_(parameters)
+  , position_(0)
+  , depth_(0)
+  , max_depth_(0)
+{
+  for(std::size_t v=0;v<variable_names_.size();v++)
+    TEUCHOS_TEST_FOR_EXCEPTION(parameters_.find(variable_names_[v])!=parameters_.end(),std::logic_error,
+                               "CompiledExpression: \"" << variable_names_[v] << "\" is both a variable and a parameter!");
+
+  parseExpression();
+  skipSpaces();
+  if(position_!=formula_.size())
+    fail("unexpected \""+formula_.substr(position_,1)+"\"");
+
+  TEUCHOS_ASSERT(depth_==1);
+}
+
+//**********************************************************************
+bool CompiledExpression::dependsOn(int variable) const
+{
+  for(std::size_t k=0;k<code_.size();k++)
+    if(code_[k].op==PUSH_VAR && code_[k].variable==variable)
+      return true;
+  return false;
+}
+
+//**********************************************************************
+void CompiledExpression::
+evaluate(int n,const double * const * variables,double * result,double * scratch) const
+{
+  int sp = -1;
+  for(std::size_t k=0;k<code_.size();k++) {
+    const Instruction & inst = code_[k];
+
+    if(inst.op==PUSH_CONST || inst.op==PUSH_VAR) {
+      double * top = scratch + (++sp)*n;
+      if(inst.op==PUSH_CONST)
+        std::fill(top,top+n,inst.value);
+      else
+        std::copy(variables[inst.variable],variables[inst.variable]+n,top);
+      continue;
+    }
+
+    double * a = scratch + sp*n;
+    switch(inst.op) {
+    case NEG:    for(int i=0;i<n;i++) a[i] = -a[i];            break;
+    case SQUARE: for(int i=0;i<n;i++) a[i] = a[i]*a[i];        break;
+    case CUBE:   for(int i=0;i<n;i++) a[i] = a[i]*a[i]*a[i];   break;
+    case SIN:    for(int i=0;i<n;i++) a[i] = std::sin(a[i]);   break;
+    case COS:    for(int i=0;i<n;i++) a[i] = std::cos(a[i]);   break;
+    case TAN:    for(int i=0;i<n;i++) a[i] = std::tan(a[i]);   break;
+    case EXP:    for(int i=0;i<n;i++) a[i] = std::exp(a[i]);   break;
+    case LOG:    for(int i=0;i<n;i++) a[i] = std::log(a[i]);   break;
+    case SQRT:   for(int i=0;i<n;i++) a[i] = std::sqrt(a[i]);  break;
+    case ABS:    for(int i=0;i<n;i++) a[i] = std::fabs(a[i]);  break;
+    case TANH:   for(int i=0;i<n;i++) a[i] = std::tanh(a[i]);  break;
+    default: {
+      // binary, the operands are the two top slots
+      a = scratch + (sp-1)*n;
+      const double * b = scratch + sp*n;
+      sp--;
+      switch(inst.op) {
+      case ADD:   for(int i=0;i<n;i++) a[i] += b[i];                       break;
+      case SUB:   for(int i=0;i<n;i++) a[i] -= b[i];                       break;
+      case MUL:   for(int i=0;i<n;i++) a[i] *= b[i];                       break;
+      case DIV:   for(int i=0;i<n;i++) a[i] /= b[i];                       break;
+      case POW:   for(int i=0;i<n;i++) a[i] = std::pow(a[i],b[i]);         break;
+      case ATAN2: for(int i=0;i<n;i++) a[i] = std::atan2(a[i],b[i]);       break;
+      case MIN:   for(int i=0;i<n;i++) a[i] = std::min(a[i],b[i]);         break;
+      case MAX:   for(int i=0;i<n;i++) a[i] = std::max(a[i],b[i]);         break;
+      default: TEUCHOS_ASSERT(false);
+      }
+    }
+    }
+  }
+
+  std::copy(scratch,scratch+n,result);
+}
+
+//**********************************************************************
+double CompiledExpression::apply(OpCode op,double a,double b)
+{
+  switch(op) {
+  case ADD:    return a+b;
+  case SUB:    return a-b;
+  case MUL:    return a*b;
+  case DIV:    return a/b;
+  case POW:    return std::pow(a,b);
+  case ATAN2:  return std::atan2(a,b);
+  case MIN:    return std::min(a,b);
+  case MAX:    return std::max(a,b);
+  case NEG:    return -a;
+  case SQUARE: return a*a;
+  case CUBE:   return a*a*a;
+  case SIN:    return std::sin(a);
+  case COS:    return std::cos(a);
+  case TAN:    return std::tan(a);
+  case EXP:    return std::exp(a);
+  case LOG:    return std::log(a);
+  case SQRT:   return std::sqrt(a);
+  case ABS:    return std::fabs(a);
+  case TANH:   return std::tanh(a);
+  default: TEUCHOS_ASSERT(false);
+  }
+  return 0.0;
+}
+
+//**********************************************************************
+// expression := term (('+'|'-') term)*
+std::size_t CompiledExpression::parseExpression()
+{
+  const std::size_t start = parseTerm();
+  while(true) {
+    if(accept('+'))
+      emitBinary(ADD,start,parseTerm());
+    else if(accept('-'))
+      emitBinary(SUB,start,parseTerm());
+    else
+      return start;
+  }
+}
+
+//**********************************************************************
+// term := unary (('*'|'/') unary)*
+std::size_t CompiledExpression::parseTerm()
+{
+  const std::size_t start = parseUnary();
+  while(true) {
+    if(accept('*'))
+      emitBinary(MUL,start,parseUnary());
+    else if(accept('/'))
+      emitBinary(DIV,start,parseUnary());
+    else
+      return start;
+  }
+}
+
+//**********************************************************************
+// unary := ('-'|'+') unary | power
+std::size_t CompiledExpression::parseUnary()
+{
+  if(accept('-')) {
+    const std::size_t start = parseUnary();
+    emitUnary(NEG,start);
+    return start;
+  }
+  if(accept('+'))
+    return parseUnary();
+  return parsePower();
+}
+
+//**********************************************************************
+// power := primary ('^' unary)?
+std::size_t CompiledExpression::parsePower()
+{
+  const std::size_t start = parsePrimary();
+  if(accept('^'))
+    emitBinary(POW,start,parseUnary());
+  return start;
+}
+
+//**********************************************************************
+// primary := number | name | name '(' expression (',' expression)? ')' | '(' expression ')'
+std::size_t CompiledExpression::parsePrimary()
+{
+  skipSpaces();
+  const std::size_t start = code_.size();
+
+  if(accept('(')) {
+    parseExpression();
+    expect(')');
+    return start;
+  }
+
+  if(position_<formula_.size() && (std::isdigit(formula_[position_]) || formula_[position_]=='.')) {
+    const char * begin = formula_.c_str()+position_;
+    char * end = 0;
+    const double value = std::strtod(begin,&end);
+    if(end==begin)
+      fail("bad number");
+    position_ += end-begin;
+    emitConstant(value);
+    return start;
+  }
+
+  std::string name;
+  while(position_<formula_.size() && (std::isalnum(formula_[position_]) || formula_[position_]=='_'))
+    name += formula_[position_++];
+  if(name=="")
+    fail("expected a number, a name or \"(\"");
+
+  if(accept('(')) {
+    static const char * unary_names[] = {"sin","cos","tan","exp","log","sqrt","abs","tanh"};
+    static const OpCode unary_ops[]   = { SIN,  COS,  TAN,  EXP,  LOG,  SQRT,  ABS,  TANH };
+    static const char * binary_names[] = {"pow","atan2","min","max"};
+    static const OpCode binary_ops[]   = { POW,  ATAN2,  MIN,  MAX };
+
+    for(int f=0;f<8;f++) {
+      if(name==unary_names[f]) {
+        parseExpression();
+        expect(')');
+        emitUnary(unary_ops[f],start);
+        return start;
+      }
+    }
+    for(int f=0;f<4;f++) {
+      if(name==binary_names[f]) {
+        parseExpression();
+        expect(',');
+        const std::size_t start_b = code_.size();
+        parseExpression();
+        expect(')');
+        emitBinary(binary_ops[f],start,start_b);
+        return start;
+      }
+    }
+    fail("unknown function \""+name+"\"");
+  }
+
+  std::vector<std::string>::const_iterator var = std::find(variable_names_.begin(),variable_names_.end(),name);
+  if(var!=variable_names_.end()) {
+    Instruction inst;
+    inst.op = PUSH_VAR;
+    inst.variable = var-variable_names_.begin();
+    inst.value = 0.0;
+    code_.push_back(inst);
+    max_depth_ = std::max(max_depth_,++depth_);
+    return start;
+  }
+
+  std::map<std::string,double>::const_iterator param = parameters_.find(name);
+  if(param!=parameters_.end())
+    emitConstant(param->second);
+  else if(name=="pi")
+    emitConstant(M_PI);
+  else if(name=="e")
+    emitConstant(M_E);
+  else
+    fail("unknown name \""+name+"\"");
+  return start;
+}
+
+//**********************************************************************
+void CompiledExpression::emitConstant(double value)
+{
+  Instruction inst;
+  inst.op = PUSH_CONST;
+  inst.variable = -1;
+  inst.value = value;
+  code_.push_back(inst);
+  max_depth_ = std::max(max_depth_,++depth_);
+}
+
+//**********************************************************************
+void CompiledExpression::emitUnary(OpCode op,std::size_t start)
+{
+  // fold a constant argument
+  if(code_.size()-start==1 && code_[start].op==PUSH_CONST) {
+    code_[start].value = apply(op,code_[start].value,0.0);
+    return;
+  }
+
+  Instruction inst;
+  inst.op = op;
+  inst.variable = -1;
+  inst.value = 0.0;
+  code_.push_back(inst);
+}
+
+//**********************************************************************
+void CompiledExpression::emitBinary(OpCode op,std::size_t start_a,std::size_t start_b)
+{
+  const bool const_a = start_b-start_a==1 && code_[start_a].op==PUSH_CONST;
+  const bool const_b = code_.size()-start_b==1 && code_[start_b].op==PUSH_CONST;
+
+  // fold two constants
+  if(const_a && const_b) {
+    code_[start_a].value = apply(op,code_[start_a].value,code_[start_b].value);
+    code_.pop_back();
+    depth_--;
+    return;
+  }
+
+  // small integer powers are multiplications
+  if(op==POW && const_b) {
+    const double p = code_[start_b].value;
+    if(p==1.0 || p==2.0 || p==3.0) {
+      code_.pop_back();
+      depth_--;
+      if(p==2.0)
+        emitUnary(SQUARE,start_a);
+      else if(p==3.0)
+        emitUnary(CUBE,start_a);
+      return;
+    }
+  }
+
+  Instruction inst;
+  inst.op = op;
+  inst.variable = -1;
+  inst.value = 0.0;
+  code_.push_back(inst);
+  depth_--;
+}
+
+//**********************************************************************
+void CompiledExpression::skipSpaces()
+{
+  while(position_<formula_.size() && std::isspace(formula_[position_]))
+    position_++;
+}
+
+//**********************************************************************
+bool CompiledExpression::accept(char c)
+{
+  skipSpaces();
+  if(position_<formula_.size() && formula_[position_]==c) {
+    position_++;
+    return true;
+  }
+  return false;
+}
+
+//**********************************************************************
+void CompiledExpression::expect(char c)
+{
+  if(!accept(c))
+    fail(std::string("expected \"")+c+"\"");
+}
+
+//**********************************************************************
+void CompiledExpression::fail(const std::string & message) const
+{
+  std::stringstream ss;
+  ss << "CompiledExpression: " << message << " at position " << position_
+     << " of \"" << formula_ << "\"";
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,ss.str());
+}
+
+}
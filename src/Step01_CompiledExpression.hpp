@@ -0,0 +1,101 @@
+#ifndef __Step01_CompiledExpression_hpp__
+#define __Step01_CompiledExpression_hpp__
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** An analytic formula, parsed once and compiled to a flat stack bytecode.
+  *
+  * The grammar is the usual one: <code>+ - * / ^</code> (<code>^</code> is right
+  * associative and binds tighter than unary minus), parentheses, numbers, the
+  * constants <code>pi</code> and <code>e</code>, the functions <code>sin cos tan
+  * exp log sqrt abs tanh</code> of one argument and <code>pow atan2 min max</code>
+  * of two. An identifier is either one of the variables, whose values are given
+  * at evaluation, or one of the parameters, whose values are substituted at
+  * compile time. Subexpressions of constants are folded, and small integer
+  * powers become multiplications.
+  *
+  * Evaluation is by blocks of points: every instruction is one loop over the
+  * block, so the loops are short, branch free and can be vectorized.
+  */
+class CompiledExpression {
+public:
+
+  /** \param[in] formula The text of the formula
+    * \param[in] variable_names Names of the variables, in the order their values are
+    *            passed to evaluate()
+    * \param[in] parameters Named constants
+    */
+  CompiledExpression(const std::string & formula,
+                     const std::vector<std::string> & variable_names,
+                     const std::map<std::string,double> & parameters);
+
+  //! Does the formula depend on the variable?
+  bool dependsOn(int variable) const;
+
+  //! Is the formula a constant (after folding)?
+  bool isConstant() const
+  { return code_.size()==1 && code_[0].op==PUSH_CONST; }
+
+  //! Doubles of scratch needed by evaluate() for a block of <code>n</code> points
+  std::size_t scratchSize(int n) const
+  { return static_cast<std::size_t>(max_depth_)*n; }
+
+  /** Evaluate at <code>n</code> points: <code>variables[v][i]</code> is the value of
+    * variable <code>v</code> at point <code>i</code>. The scratch holds at least
+    * scratchSize(n) doubles.
+    */
+  void evaluate(int n,const double * const * variables,double * result,double * scratch) const;
+
+  //! The formula as given
+  const std::string & formula() const
+  { return formula_; }
+
+private:
+
+  enum OpCode {
+    PUSH_CONST, PUSH_VAR,
+    ADD, SUB, MUL, DIV, POW, ATAN2, MIN, MAX,
+    NEG, SQUARE, CUBE, SIN, COS, TAN, EXP, LOG, SQRT, ABS, TANH
+  };
+
+  struct Instruction {
+    OpCode op;
+    int variable;
+    double value;
+  };
+
+  // recursive descent, each returns the index of the first instruction it emitted
+  std::size_t parseExpression();
+  std::size_t parseTerm();
+  std::size_t parseUnary();
+  std::size_t parsePower();
+  std::size_t parsePrimary();
+
+  void skipSpaces();
+  bool accept(char c);
+  void expect(char c);
+  void fail(const std::string & message) const;
+
+  void emitConstant(double value);
+  void emitUnary(OpCode op,std::size_t start);
+  void emitBinary(OpCode op,std::size_t start_a,std::size_t start_b);
+
+  static double apply(OpCode op,double a,double b);
+
+  std::string formula_;
+  std::vector<std::string> variable_names_;
+  std::map<std::string,double> parameters_;
+
+  std::size_t position_;
+  std::vector<Instruction> code_;
+  int depth_;
+  int max_depth_;
+};
+
+}
+
+#endif
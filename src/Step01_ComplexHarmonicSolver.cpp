@@ -0,0 +1,193 @@
+#include "Step01_ComplexHarmonicSolver.hpp"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <iostream>
+
+#include "Teuchos_Assert.hpp"
+
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Map.h"
+#include "Epetra_Vector.h"
+
+#include "BelosLinearProblem.hpp"
+#include "BelosSolverFactory.hpp"
+#include "BelosTpetraAdapter.hpp"
+
+#include "Amesos2.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+ComplexHarmonicSolver::
+ComplexHarmonicSolver(const Teuchos::RCP<const Epetra_CrsMatrix> & stiffness,
+                      const Teuchos::RCP<const Epetra_CrsMatrix> & mass,
+                      const Teuchos::RCP<const Teuchos::Comm<int> > & comm,
+                      const Teuchos::ParameterList & solverParams)
+  : stiffness_(stiffness)
+  , mass_(mass)
+  , solverParams_(solverParams)
+{
+  TEUCHOS_ASSERT(stiffness_->RowMap().SameAs(mass_->RowMap()));
+
+  type_ = solverParams_.get<std::string>("Type","Belos");
+  TEUCHOS_TEST_FOR_EXCEPTION(type_!="Belos" && type_!="Amesos2",std::runtime_error,
+                             "ComplexHarmonicSolver: unknown \"Type\" = \"" << type_ << "\", choose \"Belos\" or \"Amesos2\".");
+  solverParams_.sublist("Belos");
+  solverParams_.sublist("Amesos2");
+
+  // same owned rows in the same local order, so vectors copy entry by entry
+  const Epetra_Map & rowMap = stiffness_->RowMap();
+  std::vector<int> gids(rowMap.NumMyElements());
+  if(gids.size()>0)
+    rowMap.MyGlobalElements(&gids[0]);
+
+  map_ = Teuchos::rcp(new MapT(rowMap.NumGlobalElements(),Teuchos::arrayViewFromVector(gids),0,comm));
+
+  buildOperator();
+  x_ = Teuchos::rcp(new MultiVectorT(map_,1));
+  b_ = Teuchos::rcp(new MultiVectorT(map_,1));
+
+  // the structure does not depend on omega, so the symbolic factorization is done once
+  if(type_=="Amesos2") {
+    Teuchos::ParameterList amesosParams = solverParams_.sublist("Amesos2");
+    const std::string solverName = amesosParams.get<std::string>("Solver Type","KLU2");
+    amesosParams.remove("Solver Type");
+
+    Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList);
+    params->sublist("Amesos2") = amesosParams;
+
+    amesosSolver_ = Amesos2::create<MatrixT,MultiVectorT>(solverName,A_,x_,b_);
+    amesosSolver_->setParameters(params);
+    amesosSolver_->symbolicFactorization();
+  }
+}
+
+//**********************************************************************
+void ComplexHarmonicSolver::
+buildOperator()
+{
+  const int maxEntries = std::max(stiffness_->MaxNumEntries(),mass_->MaxNumEntries());
+
+  std::vector<double> values(maxEntries);
+  std::vector<int> indices(maxEntries);
+  std::map<int,std::pair<double,double> > row;
+  rowOffsets_.assign(1,0);
+  columns_.clear();
+  stiffnessValues_.clear();
+  massValues_.clear();
+  for(int r=0;r<stiffness_->NumMyRows();r++) {
+    const int gid = stiffness_->GRID(r);
+    int numEntries = 0;
+    row.clear();
+
+    stiffness_->ExtractGlobalRowCopy(gid,maxEntries,numEntries,&values[0],&indices[0]);
+    for(int j=0;j<numEntries;j++)
+      row[indices[j]].first += values[j];
+
+    mass_->ExtractGlobalRowCopy(gid,maxEntries,numEntries,&values[0],&indices[0]);
+    for(int j=0;j<numEntries;j++)
+      row[indices[j]].second += values[j];
+
+    for(std::map<int,std::pair<double,double> >::const_iterator itr=row.begin();itr!=row.end();++itr) {
+      columns_.push_back(itr->first);
+      stiffnessValues_.push_back(itr->second.first);
+      massValues_.push_back(itr->second.second);
+    }
+    rowOffsets_.push_back(columns_.size());
+  }
+
+  A_ = Teuchos::rcp(new MatrixT(map_,maxEntries));
+  std::vector<ScalarT> rowValues;
+  for(int r=0;r<stiffness_->NumMyRows();r++) {
+    const std::size_t begin = rowOffsets_[r], end = rowOffsets_[r+1];
+    rowValues.assign(stiffnessValues_.begin()+begin,stiffnessValues_.begin()+end);
+    A_->insertGlobalValues(stiffness_->GRID(r),
+                           Teuchos::arrayView(columns_.size()>0 ? &columns_[begin] : 0,end-begin),
+                           Teuchos::arrayViewFromVector(rowValues));
+  }
+  A_->fillComplete();
+  omega_ = 0.0;
+  factored_ = false;
+}
+
+//**********************************************************************
+void ComplexHarmonicSolver::
+setFrequency(double omega)
+{
+  if(omega==omega_)
+    return;
+
+  A_->resumeFill();
+  std::vector<ScalarT> rowValues;
+  for(int r=0;r<stiffness_->NumMyRows();r++) {
+    const std::size_t begin = rowOffsets_[r], end = rowOffsets_[r+1];
+    rowValues.resize(end-begin);
+    for(std::size_t j=begin;j<end;j++)
+      rowValues[j-begin] = ScalarT(stiffnessValues_[j],omega*massValues_[j]);
+    A_->replaceGlobalValues(stiffness_->GRID(r),
+                            Teuchos::arrayView(columns_.size()>0 ? &columns_[begin] : 0,end-begin),
+                            Teuchos::arrayViewFromVector(rowValues));
+  }
+  A_->fillComplete();
+  omega_ = omega;
+  factored_ = false;
+}
+
+//**********************************************************************
+void ComplexHarmonicSolver::
+solve(double omega,
+      const Epetra_Vector & b_re,const Epetra_Vector & b_im,
+      Epetra_Vector & x_re,Epetra_Vector & x_im)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  // Amesos2 refactors only when omega changed since the last solve
+  setFrequency(omega);
+  if(amesosSolver_!=Teuchos::null && !factored_) {
+    amesosSolver_->numericFactorization();
+    factored_ = true;
+  }
+
+  {
+    Teuchos::ArrayRCP<ScalarT> b_data = b_->getDataNonConst(0);
+    Teuchos::ArrayRCP<ScalarT> x_data = x_->getDataNonConst(0);
+    for(int i=0;i<b_re.MyLength();i++) {
+      b_data[i] = ScalarT(b_re[i],b_im[i]);
+      x_data[i] = ScalarT(x_re[i],x_im[i]);
+    }
+  }
+
+  if(type_=="Belos") {
+    RCP<Teuchos::ParameterList> belosParams = rcp(new Teuchos::ParameterList(solverParams_.sublist("Belos")));
+    const std::string solverName = belosParams->get<std::string>("Solver Type","GMRES");
+    belosParams->remove("Solver Type");
+
+    Belos::SolverFactory<ScalarT,MultiVectorT,OperatorT> factory;
+    RCP<Belos::SolverManager<ScalarT,MultiVectorT,OperatorT> > solver = factory.create(solverName,belosParams);
+
+    RCP<Belos::LinearProblem<ScalarT,MultiVectorT,OperatorT> > problem
+        = rcp(new Belos::LinearProblem<ScalarT,MultiVectorT,OperatorT>(A_,x_,b_));
+    TEUCHOS_TEST_FOR_EXCEPTION(!problem->setProblem(),std::runtime_error,
+                               "ComplexHarmonicSolver: Belos linear problem setup failed!");
+    solver->setProblem(problem);
+
+    const Belos::ReturnType result = solver->solve();
+    if(map_->getComm()->getRank()==0)
+      std::cout << "Complex harmonic solve (omega = " << omega << "): Belos "
+                << (result==Belos::Converged ? "converged" : "did not converge")
+                << " in " << solver->getNumIters() << " iterations" << std::endl;
+  }
+  else
+    amesosSolver_->solve();
+
+  Teuchos::ArrayRCP<const ScalarT> x_data = x_->getData(0);
+  for(int i=0;i<x_re.MyLength();i++) {
+    x_re[i] = x_data[i].real();
+    x_im[i] = x_data[i].imag();
+  }
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef __Step01_ComplexHarmonicSolver_hpp__
+#define __Step01_ComplexHarmonicSolver_hpp__
+
+#include <complex>
+#include <string>
+#include <vector>
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_Comm.hpp"
+#include "Teuchos_ParameterList.hpp"
+
+#include "Tpetra_Map.hpp"
+#include "Tpetra_CrsMatrix.hpp"
+#include "Tpetra_MultiVector.hpp"
+#include "Tpetra_Operator.hpp"
+
+#include "Amesos2_Solver.hpp"
+
+#include "Panzer_NodeType.hpp"
+
+class Epetra_CrsMatrix;
+class Epetra_Vector;
+
+namespace user_app {
+
+/** Solves the harmonic balance equations of a linear transient problem
+  * \f$M \dot{u} + K u = f\f$ with one complex coefficient per harmonic.
+  *
+  * Writing harmonic \f$k\f$ as \f$u_k = \mathrm{Re}(\hat{c}_k e^{i\omega_k t})\f$
+  * with \f$\hat{c}_k = a_k - i b_k\f$ (so \f$u_k = a_k\cos + b_k\sin\f$), the
+  * cosine/sine pair of real equations becomes the single complex system
+  * \f$(K + i\omega_k M)\hat{c}_k = \hat{r}_k\f$ with \f$\hat{r}_k = r_c - i r_s\f$.
+  * The complex matrix is built once on the union of the graphs of the real
+  * \f$K\f$ and \f$M\f$ and only has its values refilled for every
+  * \f$\omega\f$; it is solved with Belos or Amesos2 in complex arithmetic,
+  * so the unknowns, matrix rows and solver work are half those of the real
+  * cosine/sine form. Amesos2 does the symbolic factorization once and only
+  * refactors numerically when \f$\omega\f$ changes.
+  */
+class ComplexHarmonicSolver {
+public:
+
+  typedef std::complex<double> ScalarT;
+  typedef panzer::TpetraNodeType NodeT;
+  typedef Tpetra::Map<int,int,NodeT> MapT;
+  typedef Tpetra::CrsMatrix<ScalarT,int,int,NodeT> MatrixT;
+  typedef Tpetra::MultiVector<ScalarT,int,int,NodeT> MultiVectorT;
+  typedef Tpetra::Operator<ScalarT,int,int,NodeT> OperatorT;
+
+  /** \param[in] stiffness,mass Real matrices of the time domain equation set, with the same row map and graph
+    * \param[in] solverParams "Type" is "Belos" or "Amesos2"; the "Belos" and "Amesos2"
+    *            sublists are passed on to the chosen solver
+    */
+  ComplexHarmonicSolver(const Teuchos::RCP<const Epetra_CrsMatrix> & stiffness,
+                        const Teuchos::RCP<const Epetra_CrsMatrix> & mass,
+                        const Teuchos::RCP<const Teuchos::Comm<int> > & comm,
+                        const Teuchos::ParameterList & solverParams);
+
+  /** Solve \f$(K + i\omega M)(x_{re} + i x_{im}) = b_{re} + i b_{im}\f$.
+    * All vectors use the row map of the real matrices.
+    */
+  void solve(double omega,
+             const Epetra_Vector & b_re,const Epetra_Vector & b_im,
+             Epetra_Vector & x_re,Epetra_Vector & x_im);
+
+private:
+
+  // the graph of K + i omega M, with K and M laid out along it
+  void buildOperator();
+
+  // refill the values of the operator with K + i omega M
+  void setFrequency(double omega);
+
+  Teuchos::RCP<const Epetra_CrsMatrix> stiffness_;
+  Teuchos::RCP<const Epetra_CrsMatrix> mass_;
+  Teuchos::RCP<const MapT> map_;
+  Teuchos::ParameterList solverParams_;
+  std::string type_;
+
+  // local rows of the operator in CSR form: column GIDs, and K and M values along them
+  std::vector<std::size_t> rowOffsets_;
+  std::vector<int> columns_;
+  std::vector<double> stiffnessValues_, massValues_;
+
+  Teuchos::RCP<MatrixT> A_;
+  Teuchos::RCP<MultiVectorT> x_, b_;
+  Teuchos::RCP<Amesos2::Solver<MatrixT,MultiVectorT> > amesosSolver_;
+  // the frequency the values of A_ (and the Amesos2 factors, if factored_) belong to
+  double omega_;
+  bool factored_;
+};
+
+}
+
+#endif
@@ -56,6 +56,8 @@
 
 // begin HB mod
 #include "Step01_EquationSet_FreqDom.hpp"
+
+#include "Step01_EvaluationTypes.hpp"
 // end HB mod
 
 
@@ -72,20 +74,52 @@ namespace user_app {
   // end modification
   
   // begin HB mod
-  // this provides a placeholder template, since the user_app::EquationSet_FreqDom
-  // (defined in Step01_EquationSet_FreqDom_impl.hpp) can be used to grab the info
-  // from the appropriate time domain equation set. The problem is that
-  // we cannot grab the name of the time domain equation set at this point.
-  PANZER_DECLARE_EQSET_TEMPLATE_BUILDER("FreqDom", user_app::EquationSet_FreqDom,
-  					EquationSet_FreqDom)
-  // note that this Helmholtz set will only be created when "FreqDom" is chosen,
+  // the expanded form of PANZER_DECLARE_EQSET_TEMPLATE_BUILDER: besides the usual
+  // arguments, every user_app::EquationSet_FreqDom is handed the harmonic balance
+  // configuration, which is parsed once (in buildEquationSet) and shared by the
+  // equation sets of all evaluation types
+  class EquationSet_FreqDom_TemplateBuilder {
+    const Teuchos::RCP<const user_app::HarmonicBalanceConfig> m_hb_config;
+    const Teuchos::RCP<Teuchos::ParameterList> m_params;
+    const int m_default_integration_order;
+    const panzer::CellData& m_cell_data;
+    const Teuchos::RCP<panzer::GlobalData> m_global_data;
+    const bool m_build_transient_support;
+
+  public:
+    EquationSet_FreqDom_TemplateBuilder(const Teuchos::RCP<const user_app::HarmonicBalanceConfig>& hb_config,
+                                        const Teuchos::RCP<Teuchos::ParameterList>& params,
+                                        const int& default_integration_order,
+                                        const panzer::CellData& cd,
+                                        const Teuchos::RCP<panzer::GlobalData>& global_data,
+                                        const bool build_transient_support) :
+      m_hb_config(hb_config),
+      m_params(params),
+      m_default_integration_order(default_integration_order),
+      m_cell_data(cd),
+      m_global_data(global_data),
+      m_build_transient_support(build_transient_support) {}
+
+    template <typename EvalT>
+    Teuchos::RCP<panzer::EquationSetBase> build() const {
+      return Teuchos::rcp(new user_app::EquationSet_FreqDom<EvalT>(m_hb_config, m_params, m_default_integration_order,
+                                                                   m_cell_data, m_global_data, m_build_transient_support));
+    }
+  };
+  // note that the Helmholtz set used inside EquationSet_FreqDom will only be created when "FreqDom" is chosen,
   // so this introduces no new overhead (when a time domain transient simulation is run)
   // end HB mod
 
   class EquationSetFactory : public panzer::EquationSetFactory {
 
+    // equation sets are built for these evaluation types only
+    const user_app::EvaluationTypes m_eval_types;
+
   public:
 
+    EquationSetFactory(const user_app::EvaluationTypes & eval_types = user_app::EvaluationTypes())
+      : m_eval_types(eval_types) {}
+
     Teuchos::RCP<panzer::EquationSet_TemplateManager<panzer::Traits> >
     buildEquationSet(const Teuchos::RCP<Teuchos::ParameterList>& params,
 		     const int& default_integration_order,
@@ -95,6 +129,7 @@ namespace user_app {
     {
       Teuchos::RCP<panzer::EquationSet_TemplateManager<panzer::Traits> > eq_set= 
 	Teuchos::rcp(new panzer::EquationSet_TemplateManager<panzer::Traits>);
+      m_eval_types.disableInactive(*eq_set);
       
       bool found = false;
 
@@ -113,36 +148,20 @@ namespace user_app {
 
 
      // begin HB mod
-     // check that we are using the "FreqDom" equation set
-     // check for presence of a "FreqDom Options" sublist (parallel to the "FreqDom" equation set specification
-     // error if "FreqDom" sublist is missing
-     // grab the time domain equation set name in time_domain_eqnset 
+     // check that we are using the "FreqDom" equation set; the "FreqDom Options" sublist
+     // (parallel to the "FreqDom" equation set specification) is parsed and validated here,
+     // once, and the result is shared by the equation sets of all evaluation types
      if(params->get<std::string>("Type") == "FreqDom"){
 
         std::cout << "A frequency domain analysis is specified." << std::endl;
- 
-        if(params->isSublist("FreqDom Options")){
-
-          // grab the time domain equation set here
-	  std::cout << "Found a FreqDom Options sublist!" << std::endl;
-	  std::string& time_domain_eqnset   = params->sublist("FreqDom Options").get<std::string>("Time domain equation set");
-	  std::cout << "The time domain equation set you chose is: " + time_domain_eqnset << std::endl;
-
-	PANZER_BUILD_EQSET_OBJECTS("FreqDom", user_app::EquationSet_FreqDom, EquationSet_FreqDom)
-        // alternatively, use the expanded macro, doesn't check key
-	// EquationSet_FreqDom_TemplateBuilder builder(params, default_integration_order, cell_data, global_data, build_transient_support);
-        // eq_set->buildObjects(builder);
-
-	// assuming the time domain equation set is Helmholtz; create these alongside the FreqDom so we create its objects
 
-        } 
-        else if(!params->isSublist("FreqDom Options")) {
- 
-	   // error out if the "FreqDom Options" are missing 
-      	  std::string msg = "Error - Equation set \"FreqDom\" chosen, but missing a \"FreqDom Options\" parameter sublist!.\n";
-	  TEUCHOS_TEST_FOR_EXCEPTION(true, std::logic_error, msg);            
+        // errors out if the "FreqDom Options" are missing
+        Teuchos::RCP<const user_app::HarmonicBalanceConfig> hb_config
+          = Teuchos::rcp(new user_app::HarmonicBalanceConfig(*params));
+        std::cout << "The time domain equation set you chose is: " + hb_config->timeDomainEquationSet() << std::endl;
 
-        } 
+        EquationSet_FreqDom_TemplateBuilder builder(hb_config, params, default_integration_order, cell_data, global_data, build_transient_support);
+        eq_set->buildObjects(builder);
 
 	found = true;
      }
@@ -51,6 +51,10 @@
 #include "Panzer_Traits.hpp"
 #include "Phalanx_FieldManager.hpp"
 
+// begin HB mod
+#include "Step01_HarmonicBalanceConfig.hpp"
+// end HB mod
+
 namespace user_app {
 
 template <typename EvalT>
@@ -58,7 +62,8 @@ class EquationSet_FreqDom : public panzer::EquationSet_DefaultImpl<EvalT> {
 
 public:    
 
-  EquationSet_FreqDom(const Teuchos::RCP<Teuchos::ParameterList>& params,
+  EquationSet_FreqDom(const Teuchos::RCP<const HarmonicBalanceConfig>& hb_config,
+                         const Teuchos::RCP<Teuchos::ParameterList>& params,
                          const int& default_integration_order,
                          const panzer::CellData& cell_data,
                          const Teuchos::RCP<panzer::GlobalData>& gd,
@@ -79,6 +84,15 @@ public:
 private:
 
   std::string dof_name_;
+
+  // closure model of the equation set, for its constant fields
+  std::string model_id_;
+
+  // begin HB mod
+  // frequencies, retained harmonics and harmonic DOF names (cosine/sine pairs),
+  // shared by the equation sets of all evaluation types
+  Teuchos::RCP<const HarmonicBalanceConfig> hb_config_;
+  // end HB mod
 };
 
 }
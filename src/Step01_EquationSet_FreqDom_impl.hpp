@@ -43,6 +43,8 @@
 #ifndef __Step01_EquationSet_FreqDom_impl_hpp__
 #define __Step01_EquationSet_FreqDom_impl_hpp__
 
+#include <cmath>
+
 #include "Teuchos_ParameterList.hpp"
 #include "Teuchos_StandardParameterEntryValidators.hpp"
 #include "Teuchos_RCP.hpp"
@@ -56,6 +58,14 @@
 // include evaluators here
 #include "Panzer_Integrator_BasisTimesScalar.hpp"
 
+// begin HB mod
+#include "Step01_HarmonicBalanceAFT.hpp"
+#include "Step01_HarmonicDOF.hpp"
+#include "Step01_HarmonicTimeDerivative.hpp"
+#include "Step01_HarmonicIntegrator.hpp"
+#include "Step01_ClosureConstants.hpp"
+// end HB mod
+
 // begin modification
 #include "Panzer_Integrator_GradBasisDotVector.hpp"
 // end modification
@@ -102,12 +112,14 @@ PANZER_DECLARE_EQSET_TEMPLATE_BUILDER("FreqDom", user_app::EquationSet_Helmholtz
 
 template <typename EvalT>
 user_app::EquationSet_FreqDom<EvalT>::
-EquationSet_FreqDom(const Teuchos::RCP<Teuchos::ParameterList>& params,
+EquationSet_FreqDom(const Teuchos::RCP<const HarmonicBalanceConfig>& hb_config,
+                   const Teuchos::RCP<Teuchos::ParameterList>& params,
 		   const int& default_integration_order,
 		   const panzer::CellData& cell_data,
 		   const Teuchos::RCP<panzer::GlobalData>& global_data,
 		   const bool build_transient_support) :
-  panzer::EquationSet_DefaultImpl<EvalT>(params,default_integration_order,cell_data,global_data,build_transient_support )
+  panzer::EquationSet_DefaultImpl<EvalT>(params,default_integration_order,cell_data,global_data,build_transient_support ),
+  hb_config_(hb_config)
 {
   // ********************
   // Validate the parameters for the chosen time domain equation set
@@ -123,24 +135,16 @@ EquationSet_FreqDom(const Teuchos::RCP<Teuchos::ParameterList>& params,
     valid_parameters.set("Basis Order",1,"Order of the basis");
     valid_parameters.set("Integration Order",-1,"Order of the integration rule");
 
-  // begin HB mod
-  // validate the FreqDom Options  
-  // QUESTION: figure out why this is printed 3 times. 
-    Teuchos::ParameterList& freqdom_opt = valid_parameters.sublist("FreqDom Options");  
-    Teuchos::setStringToIntegralParameter<int>(
-      "Time domain equation set",
-      "Projection", // default gives an invalid type
-      "Choose the time domain equation set to model in the frequency domain",
-      Teuchos::tuple<std::string>("Helmholtz", "Projection"),
-      &freqdom_opt
-      );
-    freqdom_opt.set("Truncation order",3,"Truncation order of the harmonic balance method.");
+    // begin HB mod
+    // the FreqDom Options were validated when the HarmonicBalanceConfig was built
+    valid_parameters.sublist("FreqDom Options").disableRecursiveValidation();
     // end HB mod
 
     params->validateParametersAndSetDefaults(valid_parameters);
   }
 
   std::string model_id   = params->get<std::string>("Model ID");
+  model_id_ = model_id;
   std::string prefix     = params->get<std::string>("Prefix");
   std::string basis_type = params->get<std::string>("Basis Type");
   int basis_order        = params->get<int>("Basis Order");
@@ -149,7 +153,7 @@ EquationSet_FreqDom(const Teuchos::RCP<Teuchos::ParameterList>& params,
   // begin HB mod
 
   // grab the time domain equation set name
-  std::string& time_domain_eqnset = params->sublist("FreqDom Options").get<std::string>("Time domain equation set");
+  const std::string & time_domain_eqnset = hb_config_->timeDomainEquationSet();
   std::cout << "The time domain equation set we are setting up is: " << time_domain_eqnset + "." << std::endl;
   std::cout << "Do something to create multiple " + time_domain_eqnset + " equation set fields here." << std::endl;
 
@@ -157,9 +161,6 @@ EquationSet_FreqDom(const Teuchos::RCP<Teuchos::ParameterList>& params,
     Teuchos::rcp(new panzer::EquationSet_TemplateManager<panzer::Traits>);
   bool found = false;
 
-  // grab the frequency domain analysis parameters
-  int truncation_order  = params->sublist("FreqDom Options").get<int>("Truncation order");
-
   // for now, we asume the time domain eqn set is Helmholtz
   PANZER_BUILD_EQSET_OBJECTS("FreqDom", user_app::EquationSet_Helmholtz, EquationSet_Helmholtz)
   std::cout << "Called PANZER_BUILD_EQSET_OBJECTS(\"FreqDom\", user_app::EquationSet_Helmholtz, EquationSet_Helmholtz)" << std::endl;
@@ -182,16 +183,16 @@ EquationSet_FreqDom(const Teuchos::RCP<Teuchos::ParameterList>& params,
     // begin HB mod
     // we treat the default DOF's (named as per the time domain equation set) as the 0th mode
     // Need to add dof's for the higher order frequencies
-    std::string harmonic;
-
-    // for now, the total number of harmonics M is simply equal to the truncation order
-    int M = truncation_order;
-
-    for(int freq = 0 ; freq < M; freq++){    
-        harmonic = dof_name_ + "_freq" + std::to_string(freq);
-        std::cout << "Adding the " + std::to_string(freq) << "st/rd/th harmonic of the DOF." << std::endl;
-	this->addDOF(harmonic, basis_type, basis_order, integration_order);
-        this->addDOFGrad(harmonic);
+    // each retained harmonic k contributes a cosine and a sine coefficient, and the
+    // time derivative only couples those two; see buildAndRegisterEquationSetEvaluators
+    TEUCHOS_ASSERT(hb_config_->meanDOFName()==dof_name_);
+    const std::vector<std::string> & harmonic_dof_names = hb_config_->harmonicDOFNames();
+    std::cout << "Truncation keeps " << hb_config_->harmonics().size() << " harmonics." << std::endl;
+
+    // no addDOFGrad: values and gradients of all harmonics at the integration points
+    // come from a single HarmonicDOF evaluator, see buildAndRegisterEquationSetEvaluators
+    for(std::size_t i = 0 ; i < harmonic_dof_names.size(); i++){    
+      this->addDOF(harmonic_dof_names[i], basis_type, basis_order, integration_order);
     }
     // end HB mod
 
@@ -209,91 +210,61 @@ buildAndRegisterEquationSetEvaluators(PHX::FieldManager<panzer::Traits>& fm,
 				      const panzer::FieldLibrary& fl,
 				      const Teuchos::ParameterList& user_data) const
 {
-  // build the time domain equation set objects
-  // grab the required inputs
-  Teuchos::RCP<Teuchos::ParameterList> input_params = Teuchos::rcp(new Teuchos::ParameterList("User_App Parameters"));
-  Teuchos::updateParametersFromXmlFile("input.xml", input_params.ptr());
-  Teuchos::RCP<Teuchos::ParameterList> physics_blocks_pl   = Teuchos::rcp(new Teuchos::ParameterList(input_params->sublist("Physics Blocks")));
-  Teuchos::RCP<Teuchos::ParameterList> domain_pl   = Teuchos::rcp(new Teuchos::ParameterList(physics_blocks_pl->sublist("domain")));
-  Teuchos::RCP<Teuchos::ParameterList> params  = Teuchos::rcp(new Teuchos::ParameterList(domain_pl->sublist("child0")));
-  Teuchos::RCP<Teuchos::ParameterList> freqdom_pl   = Teuchos::rcp(new Teuchos::ParameterList(params->sublist("FreqDom Options")));
-
+  // build the time domain equation set objects, everything needed is in the shared configuration
   std::cout << "The EquationSet_FreqDom::buildAndRegisterEquationSetEvaluators() function was called!\n" 
-            << "The time domain equation specified is: " << freqdom_pl->get<std::string>("Time domain equation set")
+            << "The time domain equation specified is: " << hb_config_->timeDomainEquationSet()
             << ". We will attempt to build its fields now." << std::endl;
 
   using Teuchos::ParameterList;
   using Teuchos::RCP;
   using Teuchos::rcp;
 
-  // grabbing the harmonic balance options
-  int truncation_order  = params->sublist("FreqDom Options").get<int>("Truncation order");
-  // TODO: build and register the evaluators from the time domain equation set here
-  // for now, assuming the Helmholtz equation set
-  user_app::EquationSet_FreqDom<EvalT>::buildAndRegisterEquationSetEvaluators_Helmholtz(fm, fl, user_data);
-
-
-  // define some special strings to use
-  const std::string residual_timesfive_term     = "RESIDUAL_"+dof_name_+"_TIMESFIVE";
-  // this must be satisfied by the closure model
-
   // ********************
-  // Times five operator
+  // Harmonic fields at the integration points
   // ********************
 
+  // all harmonics share one (Cell,Harmonic,Point) field, 0th mode first, so every
+  // evaluator below makes a single pass over the workset instead of one per harmonic
+
   RCP<panzer::IntegrationRule> ir  = this->getIntRuleForDOF(dof_name_); 
   RCP<panzer::BasisIRLayout> basis = this->getBasisIRLayoutForDOF(dof_name_); 
 
-  {
-    ParameterList p;
-    p.set("Residual Name", residual_timesfive_term);
-    p.set("Value Name",    dof_name_);
-    p.set("Basis",         basis);
-    p.set("IR",            ir);
-    p.set("Multiplier",    0.0);
+  const std::vector<std::string> & dof_names = hb_config_->dofNames();
 
+  // values and gradients of all harmonics, from the gathered basis coefficients
+  {
     RCP<PHX::Evaluator<panzer::Traits> > op =
-      rcp(new panzer::Integrator_BasisTimesScalar<EvalT,panzer::Traits>(p));
+      rcp(new user_app::HarmonicDOF<EvalT,panzer::Traits>(dof_names,"HARMONIC_"+dof_name_,"GRAD_HARMONIC_"+dof_name_,*basis,*ir));
 
     this->template registerEvaluator<EvalT>(fm, op);
   }
 
-  // Use a sum operator to form the overall residual for the equation
-  // - this way we avoid loading each operator separately into the
-  // global residual and Jacobian
-
+  // harmonic coupling operator: u_t is a cosine/sine swap in the harmonic dimension
+  // (see HarmonicTimeDerivative). This is the only place harmonics talk to each other
+  // for a linear equation set, which makes the HB Jacobian block diagonal in the
+  // cosine/sine pairs.
   {
-    std::vector<std::string> residual_operator_names;
-
-    // add a bogus evaluated field (which is actually equal to 0)
-    // this is the only field evaluated in this equation set
-    residual_operator_names.push_back(residual_timesfive_term);
+    RCP<PHX::Evaluator<panzer::Traits> > op =
+      rcp(new user_app::HarmonicTimeDerivative<EvalT,panzer::Traits>("HARMONIC_"+dof_name_,"DXDT_HARMONIC_"+dof_name_,
+                                                                     hb_config_->harmonicDOFFrequencies(),*ir));
 
-    // begin HB mod
-    // trying to add a field which has an evaluator in a different equation set
-    // some strings defined from the Helmholtz equation set (residual names)
-    const std::string residual_projection_term     = "RESIDUAL_"+dof_name_+"_PROJECTION";
-    const std::string residual_projection_src_term = "RESIDUAL_"+dof_name_+"_PROJECTION_SOURCE";
-    const std::string projection_src_name = dof_name_+"_SOURCE";
-    const std::string residual_laplacian_term      = "RESIDUAL_"+dof_name_+"_LAPLACIAN";
-    // trying to add those evaluated fields into this residual
-    residual_operator_names.push_back(residual_projection_term);
-    residual_operator_names.push_back(residual_projection_src_term);
-    residual_operator_names.push_back(residual_laplacian_term);
-    // end HB mod
+    this->template registerEvaluator<EvalT>(fm, op);
+  }
 
-    // build a sum evaluator
-    this->buildAndRegisterResidualSummationEvalautor(fm,dof_name_,residual_operator_names);
+  // nonlinear operator (AFT): go to the time domain with an FFT, evaluate c u^3
+  // there and transform back
+  if(hb_config_->nonlinearCoefficient()!=0.0) {
+    RCP<PHX::Evaluator<panzer::Traits> > op =
+      rcp(new user_app::HarmonicBalanceAFT<EvalT,panzer::Traits>("HARMONIC_"+dof_name_,"AFT_HARMONIC_"+dof_name_,dof_names.size(),
+                                                                 hb_config_->nonlinearCoefficient(),hb_config_->aftTimeSamples(),*ir));
 
-    // register residual evaluators for each harmonic
-    // for now, as above, the total number of harmonics M is simply equal to the truncation order
-    int M = truncation_order;
-    for(int freq = 0 ; freq < M; freq++){
-      this->buildAndRegisterResidualSummationEvalautor(fm,dof_name_+ "_freq" + std::to_string(freq),residual_operator_names);
-      std::cout << "Adding the " + std::to_string(freq) << "st/nd/rd/th residual corresponding to harmonic DOF." << std::endl;
-    }
+    this->template registerEvaluator<EvalT>(fm, op);
   }
 
+  // TODO: build and register the evaluators from the time domain equation set here
+  // for now, assuming the Helmholtz equation set
+  user_app::EquationSet_FreqDom<EvalT>::buildAndRegisterEquationSetEvaluators_Helmholtz(fm, fl, user_data);
+
   fm.writeGraphvizFile<panzer::Traits::Residual>("graph_residual.dot");
   fm.writeGraphvizFile<panzer::Traits::Jacobian>("graph_jacobian.dot");
 
@@ -310,9 +281,10 @@ buildAndRegisterEquationSetEvaluators(PHX::FieldManager<panzer::Traits>& fm,
 // in the future, we should call the buildAndRegisterEquationSetEvaluators function
 // from the time domain equation set, instead of hacking it into EquationSet_FreqDom
 
-// the goal is to minimally modify the residual evaluator from the time domain equation set
-// note that the residual pushed back by the time domain equation set is NOT the complete
-// 0th order harmonic residual
+// the goal is to minimally modify the residual evaluator from the time domain equation set,
+// applied in the harmonic layout: the terms of the time domain set act on every harmonic,
+// the coupling between harmonics (u_t) and the AFT term are evaluated by the FreqDom set
+// itself. The source is time independent, so it only enters the 0th mode.
 
 template <typename EvalT>
 void user_app::EquationSet_FreqDom<EvalT>::
@@ -327,18 +299,9 @@ buildAndRegisterEquationSetEvaluators_Helmholtz(PHX::FieldManager<panzer::Traits
   using Teuchos::RCP;
   using Teuchos::rcp;
 
-  // define some special strings to use
-  const std::string residual_projection_term     = "RESIDUAL_"+dof_name_+"_PROJECTION";
-  const std::string residual_projection_src_term = "RESIDUAL_"+dof_name_+"_PROJECTION_SOURCE";
-  
   const std::string projection_src_name = dof_name_+"_SOURCE";
     // this must be satisfied by the closure model
 
-  // begin modification
-  const std::string residual_laplacian_term      = "RESIDUAL_"+dof_name_+"_LAPLACIAN";
-  // end modification
-
-
   // ********************
   // Helmholtz Equation
   // ********************
@@ -346,73 +309,42 @@ buildAndRegisterEquationSetEvaluators_Helmholtz(PHX::FieldManager<panzer::Traits
   RCP<panzer::IntegrationRule> ir  = this->getIntRuleForDOF(dof_name_); 
   RCP<panzer::BasisIRLayout> basis = this->getBasisIRLayoutForDOF(dof_name_); 
 
-  // Projection operator (U,phi)
+  const std::vector<std::string> & dof_names = hb_config_->dofNames();
+
+  // one integrator for all harmonics:
+  //   projection (u,phi) + harmonic coupling (u_t,phi) + nonlinear (c u^3,phi)
+  //   + laplacian (grad u,grad phi) - source (u_source,phi) [0th mode only]
+  // It writes the residual of every harmonic DOF directly, so there is no summation
+  // evaluator; the scatter picks up "RESIDUAL_"+dof_name as usual.
   {
-    ParameterList p;
-    p.set("Residual Name", residual_projection_term);
-    p.set("Value Name",    dof_name_);
-    p.set("Basis",         basis);
-    p.set("IR",            ir);
-    p.set("Multiplier",    1.0);
+    RCP<std::vector<std::string> > residual_names = rcp(new std::vector<std::string>);
+    for(std::size_t i = 0; i < dof_names.size(); i++)
+      residual_names->push_back("RESIDUAL_"+dof_names[i]);
 
-    RCP<PHX::Evaluator<panzer::Traits> > op = 
-      rcp(new panzer::Integrator_BasisTimesScalar<EvalT,panzer::Traits>(p));
-    
-    this->template registerEvaluator<EvalT>(fm, op);
-  }
+    RCP<std::vector<std::string> > value_names = rcp(new std::vector<std::string>);
+    value_names->push_back("HARMONIC_"+dof_name_);
+    value_names->push_back("DXDT_HARMONIC_"+dof_name_);
+    if(hb_config_->nonlinearCoefficient()!=0.0)
+      value_names->push_back("AFT_HARMONIC_"+dof_name_);
 
-  // Source operator -(u_source,phi)
-  {
     ParameterList p;
-    p.set("Residual Name", residual_projection_src_term);
-    p.set("Value Name",    projection_src_name);
-    p.set("Basis",         basis);
-    p.set("IR",            ir);
-    p.set("Multiplier",    -1.0);
+    p.set("Residual Names", residual_names.getConst());
+    p.set("Value Names",    value_names.getConst());
+    p.set("Flux Name",      "GRAD_HARMONIC_"+dof_name_);
+    double source_value = 0.0;
+    if(user_app::findClosureConstant(user_data,model_id_,projection_src_name,source_value))
+      p.set("Mean Source Value", source_value);
+    else
+      p.set("Mean Source Name", projection_src_name);
+    p.set("Mean Source Multiplier", -1.0);
+    p.set("Basis",          basis);
+    p.set("IR",             ir);
 
     RCP<PHX::Evaluator<panzer::Traits> > op = 
-      rcp(new panzer::Integrator_BasisTimesScalar<EvalT,panzer::Traits>(p));
+      rcp(new user_app::HarmonicIntegrator<EvalT,panzer::Traits>(p));
     
     this->template registerEvaluator<EvalT>(fm, op);
   }
-
-  // begin modification
-  // Laplacian operator (grad u , grad basis)
-  {
-    ParameterList p;
-    p.set("Residual Name", residual_laplacian_term);
-    p.set("Flux Name", "GRAD_"+dof_name_);
-    p.set("Basis", basis);
-    p.set("IR", ir);
-    p.set("Multiplier", 1.0);
-
-    RCP< PHX::Evaluator<panzer::Traits> > op =
-      rcp(new panzer::Integrator_GradBasisDotVector<EvalT,panzer::Traits>(p));
-    fm.template registerEvaluator<EvalT>(op);
-  }
-  // end modification
-  // note that we do not have to explicitly evaluate a "GRAD_"+dof_name_ field
-
-  // Use a sum operator to form the overall residual for the equation
-  // - this way we avoid loading each operator separately into the
-  // global residual and Jacobian
-
-  // don't push back the residual here; instead, push it back in the FreqDom's buildAndRegisterEvalautors()
-  /*
-  {
-    std::vector<std::string> residual_operator_names;
-
-    residual_operator_names.push_back(residual_projection_term);
-    residual_operator_names.push_back(residual_projection_src_term);
-
-    // begin modification
-    residual_operator_names.push_back(residual_laplacian_term);
-    // end modification
-
-    // build a sum evaluator
-    this->buildAndRegisterResidualSummationEvalautor(fm,dof_name_,residual_operator_names);
-  }
-  */
 }
 
 // end HB mod
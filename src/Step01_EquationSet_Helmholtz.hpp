@@ -71,6 +71,13 @@ public:
 private:
 
   std::string dof_name_;
+
+  // closure model of the equation set, for its constant fields
+  std::string model_id_;
+
+  // begin HB mod
+  double nonlinear_coefficient_;
+  // end HB mod
 };
 
 }
@@ -54,11 +54,9 @@
 #include "Panzer_BasisIRLayout.hpp"
 
 // include evaluators here
-#include "Panzer_Integrator_BasisTimesScalar.hpp"
-
-// begin modification
-#include "Panzer_Integrator_GradBasisDotVector.hpp"
-// end modification
+#include "Step01_Helmholtz_Residual.hpp"
+#include "Step01_Helmholtz_ResidualSumFactorized.hpp"
+#include "Step01_ClosureConstants.hpp"
 
 // ***********************************************************************
 template <typename EvalT>
@@ -82,6 +80,9 @@ EquationSet_Helmholtz(const Teuchos::RCP<Teuchos::ParameterList>& params,
     valid_parameters.set("Basis Type","HGrad","Type of Basis to use");
     valid_parameters.set("Basis Order",1,"Order of the basis");
     valid_parameters.set("Integration Order",-1,"Order of the integration rule");
+    // begin HB mod
+    valid_parameters.set("Nonlinear reaction coefficient",0.0,"Coefficient c of a c*u^3 reaction term (the time domain form of the FreqDom term).");
+    // end HB mod
 
     // begin HB mod (must be added to existing time domain equation sets)
     // essentially to ignore the "FreqDom" sublist for the time domain construction
@@ -100,10 +101,14 @@ EquationSet_Helmholtz(const Teuchos::RCP<Teuchos::ParameterList>& params,
   }
 
   std::string model_id   = params->get<std::string>("Model ID");
+  model_id_ = model_id;
   std::string prefix     = params->get<std::string>("Prefix");
   std::string basis_type = params->get<std::string>("Basis Type");
   int basis_order        = params->get<int>("Basis Order");
   int integration_order  = params->get<int>("Integration Order");
+  // begin HB mod
+  nonlinear_coefficient_ = params->get<double>("Nonlinear reaction coefficient");
+  // end HB mod
 
   // ********************
   // Setup DOFs and closure models
@@ -117,6 +122,12 @@ EquationSet_Helmholtz(const Teuchos::RCP<Teuchos::ParameterList>& params,
     // end modication
     // question: what other kinds of fields can be automatically created?
 
+    // begin HB mod
+    // the time derivative gives the mass matrix (alpha term) of the transient problem,
+    // which the harmonic balance operators are built from
+    if (this->buildTransientSupport())
+      this->addDOFTimeDerivative(dof_name_);
+    // end HB mod
   }
 
   this->addClosureModel(model_id);
@@ -138,18 +149,9 @@ buildAndRegisterEquationSetEvaluators(PHX::FieldManager<panzer::Traits>& fm,
   using Teuchos::RCP;
   using Teuchos::rcp;
 
-  // define some special strings to use
-  const std::string residual_projection_term     = "RESIDUAL_"+dof_name_+"_PROJECTION";
-  const std::string residual_projection_src_term = "RESIDUAL_"+dof_name_+"_PROJECTION_SOURCE";
-  
   const std::string projection_src_name = dof_name_+"_SOURCE";
     // this must be satisfied by the closure model
 
-  // begin modification
-  const std::string residual_laplacian_term      = "RESIDUAL_"+dof_name_+"_LAPLACIAN";
-  // end modification
-
-
   // ********************
   // Helmholtz Equation
   // ********************
@@ -157,70 +159,47 @@ buildAndRegisterEquationSetEvaluators(PHX::FieldManager<panzer::Traits>& fm,
   RCP<panzer::IntegrationRule> ir  = this->getIntRuleForDOF(dof_name_); 
   RCP<panzer::BasisIRLayout> basis = this->getBasisIRLayoutForDOF(dof_name_); 
 
-  // Projection operator (U,phi)
-  {
-    ParameterList p;
-    p.set("Residual Name", residual_projection_term);
-    p.set("Value Name",    dof_name_);
-    p.set("Basis",         basis);
-    p.set("IR",            ir);
-    p.set("Multiplier",    1.0);
-
-    RCP<PHX::Evaluator<panzer::Traits> > op = 
-      rcp(new panzer::Integrator_BasisTimesScalar<EvalT,panzer::Traits>(p));
-    
-    this->template registerEvaluator<EvalT>(fm, op);
-  }
-
-  // Source operator -(u_source,phi)
+  // the whole residual in one evaluator:
+  //   projection (U,phi) - source (u_source,phi) + laplacian (grad u,grad basis)
+  // begin HB mod
+  //   + transient (dU/dt,phi) + nonlinear (c u^3,phi)
+  // end HB mod
+  // so there is no residual field per operator and no sum evaluator
   {
     ParameterList p;
-    p.set("Residual Name", residual_projection_src_term);
-    p.set("Value Name",    projection_src_name);
+    p.set("Residual Name", "RESIDUAL_"+dof_name_);
+    p.set("DOF Name",      dof_name_);
+    double source_value = 0.0;
+    if (user_app::findClosureConstant(user_data,model_id_,projection_src_name,source_value))
+      p.set("Source Value", source_value);
+    else
+      p.set("Source Name",   projection_src_name);
+    // begin HB mod
+    if (this->buildTransientSupport())
+      p.set("Time Derivative Name", "DXDT_"+dof_name_);
+    p.set("Nonlinear Coefficient", nonlinear_coefficient_);
+    // end HB mod
     p.set("Basis",         basis);
     p.set("IR",            ir);
-    p.set("Multiplier",    -1.0);
 
-    RCP<PHX::Evaluator<panzer::Traits> > op = 
-      rcp(new panzer::Integrator_BasisTimesScalar<EvalT,panzer::Traits>(p));
+    // tensor-product quads at higher order: sum factorization costs O(p^3) per cell
+    // instead of the O(p^4) of full basis by point contractions; its 1D factors are
+    // reference values, so only bases whose DOFs need no orientation qualify
+    const bool sum_factorize = std::string(ir->topology->getName())=="Quadrilateral_4" &&
+                               basis->getBasis()->type()=="HGrad" &&
+                               basis->getBasis()->order()>=2 &&
+                               !basis->getBasis()->requiresOrientations();
+
+    RCP<PHX::Evaluator<panzer::Traits> > op;
+    if (sum_factorize)
+      op = rcp(new user_app::Helmholtz_ResidualSumFactorized<EvalT,panzer::Traits>(p));
+    else
+      op = rcp(new user_app::Helmholtz_Residual<EvalT,panzer::Traits>(p));
     
     this->template registerEvaluator<EvalT>(fm, op);
   }
-
-  // begin modification
-  // Laplacian operator (grad u , grad basis)
-  {
-    ParameterList p;
-    p.set("Residual Name", residual_laplacian_term);
-    p.set("Flux Name", "GRAD_"+dof_name_);
-    p.set("Basis", basis);
-    p.set("IR", ir);
-    p.set("Multiplier", 1.0);
-
-    RCP< PHX::Evaluator<panzer::Traits> > op =
-      rcp(new panzer::Integrator_GradBasisDotVector<EvalT,panzer::Traits>(p));
-    fm.template registerEvaluator<EvalT>(op);
-  }
-  // end modification
   // note that we do not have to explicitly evaluate a "GRAD_"+dof_name_ field
 
-  // Use a sum operator to form the overall residual for the equation
-  // - this way we avoid loading each operator separately into the
-  // global residual and Jacobian
-  {
-    std::vector<std::string> residual_operator_names;
-
-    residual_operator_names.push_back(residual_projection_term);
-    residual_operator_names.push_back(residual_projection_src_term);
-
-    // begin modification
-    residual_operator_names.push_back(residual_laplacian_term);
-    // end modification
-
-    // build a sum evaluator
-    this->buildAndRegisterResidualSummationEvalautor(fm,dof_name_,residual_operator_names);
-  }
-
 }
 
 // ***********************************************************************
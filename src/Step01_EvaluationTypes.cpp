@@ -0,0 +1,54 @@
+#include "Step01_EvaluationTypes.hpp"
+
+#include <stdexcept>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+std::set<std::string> EvaluationTypes::allNames()
+{
+  std::set<std::string> names;
+  names.insert(PHX::typeAsString<panzer::Traits::Residual>());
+  names.insert(PHX::typeAsString<panzer::Traits::Jacobian>());
+  names.insert(PHX::typeAsString<panzer::Traits::Tangent>());
+#ifdef Panzer_BUILD_HESSIAN_SUPPORT
+  names.insert(PHX::typeAsString<panzer::Traits::Hessian>());
+#endif
+  return names;
+}
+
+//**********************************************************************
+EvaluationTypes::EvaluationTypes()
+  : active_(allNames())
+{ }
+
+//**********************************************************************
+EvaluationTypes::EvaluationTypes(const Teuchos::Array<std::string> & names)
+{
+  const std::set<std::string> all = allNames();
+  for(int i=0;i<names.size();i++) {
+    TEUCHOS_TEST_FOR_EXCEPTION(all.find(names[i])==all.end(),std::runtime_error,
+                               "Unknown evaluation type \"" << names[i] << "\".");
+    active_.insert(names[i]);
+  }
+
+  TEUCHOS_TEST_FOR_EXCEPTION(!isActive<panzer::Traits::Residual>(),std::runtime_error,
+                             "The \"Residual\" evaluation type is always required.");
+}
+
+//**********************************************************************
+std::vector<bool> EvaluationTypes::activeFlags() const
+{
+  std::vector<bool> flags;
+  flags.push_back(isActive<panzer::Traits::Residual>());
+  flags.push_back(isActive<panzer::Traits::Jacobian>());
+  flags.push_back(isActive<panzer::Traits::Tangent>());
+#ifdef Panzer_BUILD_HESSIAN_SUPPORT
+  flags.push_back(isActive<panzer::Traits::Hessian>());
+#endif
+  return flags;
+}
+
+}
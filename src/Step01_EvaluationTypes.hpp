@@ -0,0 +1,70 @@
+#ifndef __Step01_EvaluationTypes_hpp__
+#define __Step01_EvaluationTypes_hpp__
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Teuchos_Array.hpp"
+
+#include "Panzer_Traits.hpp"
+
+namespace user_app {
+
+/** The evaluation types of panzer::Traits that a run evaluates.
+  *
+  * Equation sets, closure models and field managers are otherwise built for every
+  * type in panzer::Traits::EvalTypes. Template managers for the others are disabled
+  * with disableInactive() before their objects are built, and field managers are
+  * restricted with activeFlags(), so those types cost neither setup time nor field
+  * memory.
+  */
+class EvaluationTypes {
+public:
+
+  //! All the evaluation types
+  EvaluationTypes();
+
+  /** The named types ("Residual", "Jacobian", "Tangent" and, with Hessian support,
+    * "Hessian"). The residual is always needed: it carries the DOF layout and the
+    * responses.
+    */
+  EvaluationTypes(const Teuchos::Array<std::string> & names);
+
+  template<typename EvalT>
+  bool isActive() const
+  { return active_.find(PHX::typeAsString<EvalT>())!=active_.end(); }
+
+  //! Disable the inactive types of a template manager, before its <code>buildObjects()</code>
+  template<typename TemplateManagerT>
+  void disableInactive(TemplateManagerT & tm) const
+  {
+    if(!isActive<panzer::Traits::Jacobian>())
+      tm.template disableType<panzer::Traits::Jacobian>();
+    if(!isActive<panzer::Traits::Tangent>())
+      tm.template disableType<panzer::Traits::Tangent>();
+#ifdef Panzer_BUILD_HESSIAN_SUPPORT
+    if(!isActive<panzer::Traits::Hessian>())
+      tm.template disableType<panzer::Traits::Hessian>();
+#endif
+  }
+
+  /** One flag per type of panzer::Traits::EvalTypes, in that order, as
+    * FieldManagerBuilder::setActiveEvaluationTypes() takes them
+    */
+  std::vector<bool> activeFlags() const;
+
+  //! The active types, e.g. for printing
+  const std::set<std::string> & names() const
+  { return active_; }
+
+private:
+
+  static std::set<std::string> allNames();
+
+  std::set<std::string> active_;
+};
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef __Step01_ExpressionFunction_hpp__
+#define __Step01_ExpressionFunction_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_CompiledExpression.hpp"
+#include "Step01_IntegrationPointCache.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** A source given by a formula in <code>x</code>, <code>y</code>, <code>t</code> and
+  * named parameters, e.g. <code>"sin(2*pi*a*x)*exp(-t)"</code>.
+  *
+  * The formula is compiled once (see CompiledExpression) and evaluated over the
+  * integration points of a workset in blocks, the blocks in parallel. A formula
+  * without <code>t</code> depends on the geometry only and is evaluated once per
+  * workset, like the other closure models.
+  */
+template<typename EvalT, typename Traits>
+class ExpressionFunction : public PHX::EvaluatorWithBaseImpl<Traits>,
+                           public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    ExpressionFunction(const std::string & name,
+                       const std::string & formula,
+                       const std::map<std::string,double> & parameters,
+                       const panzer::IntegrationRule & ir);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+
+  // the variables of a formula, in the order they are passed to CompiledExpression::evaluate
+  static std::vector<std::string> variableNames();
+
+  // points per block: few enough for the stack of the expression to stay in cache
+  static const int block_size_ = 128;
+
+  // evaluate the formula at the points of a workset, (Cell,Point) ordered
+  void compute(const panzer::Workset & workset,double * values);
+
+  // Simulation source, passive: it does not depend on the solution
+  PHX::MDField<double,panzer::Cell,panzer::Point> result;
+
+  CompiledExpression expression_;
+  bool time_dependent_;
+
+  int ir_degree_;
+  int ir_index_;
+
+  IntegrationPointCache cache_;
+
+  // x, y, t at the points, the values when they are not cached, and the block scratch
+  std::vector<double> x_, y_, t_, values_, scratch_;
+};
+
+}
+
+#endif
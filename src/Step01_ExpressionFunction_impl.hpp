@@ -0,0 +1,131 @@
+#ifndef __Step01_ExpressionFunction_impl_hpp__
+#define __Step01_ExpressionFunction_impl_hpp__
+
+#include <algorithm>
+
+#include "Panzer_BasisIRLayout.hpp"
+#include "Panzer_Workset.hpp"
+#include "Panzer_Workset_Utilities.hpp"
+
+#include "Step01_CellPointPolicy.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+ExpressionFunction<EvalT,Traits>::ExpressionFunction(const std::string & name,
+                                                     const std::string & formula,
+                                                     const std::map<std::string,double> & parameters,
+                                                     const panzer::IntegrationRule & ir)
+  : expression_(formula,variableNames(),parameters)
+  , ir_degree_(ir.cubature_degree)
+{
+  time_dependent_ = expression_.dependsOn(2);
+
+  Teuchos::RCP<PHX::DataLayout> data_layout = ir.dl_scalar;
+
+  result = PHX::MDField<double,panzer::Cell,panzer::Point>(name, data_layout);
+  this->addEvaluatedField(result);
+
+  this->setName("Expression Function("+name+" = "+formula+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void ExpressionFunction<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                            PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(result,fm);
+
+  ir_index_ = panzer::getIntegrationRuleIndex(ir_degree_,(*sd.worksets_)[0]);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void ExpressionFunction<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_points = result.extent_int(1);
+
+  const double * values = 0;
+  if(time_dependent_) {
+    values_.resize(workset.num_cells*num_points);
+    if(!values_.empty()) {
+      compute(workset,&values_[0]);
+      values = &values_[0];
+    }
+  }
+  else {
+    values = cache_.find(workset,ir_index_);
+    if(values==0) {
+      double * new_values = cache_.insert(workset,ir_index_,num_points);
+      compute(workset,new_values);
+      values = new_values;
+    }
+  }
+
+  // the lambda captures copies, not this
+  PHX::MDField<double,panzer::Cell,panzer::Point> result_field = result;
+  Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                       KOKKOS_LAMBDA (const long cell,const long point) {
+    result_field(cell,point) = values[cell*num_points+point];
+  });
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+std::vector<std::string> ExpressionFunction<EvalT,Traits>::variableNames()
+{
+  std::vector<std::string> names;
+  names.push_back("x");
+  names.push_back("y");
+  names.push_back("t");
+  return names;
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void ExpressionFunction<EvalT,Traits>::compute(const panzer::Workset & workset,double * values)
+{
+  const int num_points = result.extent_int(1);
+  const int n = workset.num_cells*num_points;
+  if(n==0)
+    return;
+
+  x_.resize(n);
+  y_.resize(n);
+  t_.assign(n,workset.time);
+  {
+    const auto ip_coordinates = workset.int_rules[ir_index_]->ip_coordinates;
+    double * x = &x_[0];
+    double * y = &y_[0];
+    Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                         KOKKOS_LAMBDA (const long cell,const long point) {
+      x[cell*num_points+point] = ip_coordinates(cell,point,0);
+      y[cell*num_points+point] = ip_coordinates(cell,point,1);
+    });
+  }
+
+  // each block has its own slice of the scratch
+  const int block_size = block_size_;
+  const int num_blocks = (n+block_size-1)/block_size;
+  const std::size_t block_scratch = expression_.scratchSize(block_size);
+  scratch_.resize(num_blocks*block_scratch);
+
+  const CompiledExpression * expression = &expression_;
+  const double * x = &x_[0];
+  const double * y = &y_[0];
+  const double * t = &t_[0];
+  double * scratch = &scratch_[0];
+  Kokkos::parallel_for(Kokkos::RangePolicy<CellPointExecutionSpace>(0,num_blocks),
+                       KOKKOS_LAMBDA (const int block) {
+    const int first = block*block_size;
+    const int size = std::min(block_size,n-first);
+    const double * variables[3] = { x+first, y+first, t+first };
+    expression->evaluate(size,variables,values+first,scratch+block*block_scratch);
+  });
+}
+
+//**********************************************************************
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "Step01_FieldTransfer.hpp"
+
+#include <vector>
+
+#include "Teuchos_Assert.hpp"
+
+#include "Kokkos_DynRankView.hpp"
+#include "Phalanx_KokkosDeviceTypes.hpp"
+
+#include "Panzer_STK_Interface.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_Import.h"
+#include "Epetra_Map.h"
+#include "Epetra_Vector.h"
+
+namespace user_app {
+
+//**********************************************************************
+void copyFieldValues(const panzer::UniqueGlobalIndexer<int,int> & srcIndexer,
+                     const std::string & srcField,
+                     const Epetra_Vector & src,
+                     const panzer::UniqueGlobalIndexer<int,int> & dstIndexer,
+                     const std::string & dstField,
+                     Epetra_Vector & dst)
+{
+  const int srcFieldNum = srcIndexer.getFieldNum(srcField);
+  const int dstFieldNum = dstIndexer.getFieldNum(dstField);
+  TEUCHOS_TEST_FOR_EXCEPTION(srcFieldNum<0 || dstFieldNum<0,std::logic_error,
+                             "copyFieldValues: field \"" << srcField << "\" or \"" << dstField << "\" does not exist!");
+
+  // ghost the source so every DOF of a local element is available
+  std::vector<int> ghostedGids;
+  srcIndexer.getOwnedAndGhostedIndices(ghostedGids);
+  Epetra_Map ghostedMap(-1,ghostedGids.size(),ghostedGids.size()>0 ? &ghostedGids[0] : 0,0,src.Comm());
+  Epetra_Import importer(ghostedMap,src.Map());
+  Epetra_Vector ghostedSrc(ghostedMap);
+  ghostedSrc.Import(src,importer,Insert);
+
+  std::vector<std::string> elementBlockIds;
+  dstIndexer.getElementBlockIds(elementBlockIds);
+
+  std::vector<int> srcGids, dstGids;
+  for(std::size_t eb=0;eb<elementBlockIds.size();eb++) {
+    const std::string & blockId = elementBlockIds[eb];
+
+    const std::vector<int> & srcOffsets = srcIndexer.getGIDFieldOffsets(blockId,srcFieldNum);
+    const std::vector<int> & dstOffsets = dstIndexer.getGIDFieldOffsets(blockId,dstFieldNum);
+    if(dstOffsets.size()==0)
+      continue;
+    TEUCHOS_ASSERT(srcOffsets.size()==dstOffsets.size());
+
+    const std::vector<int> & elements = dstIndexer.getElementBlock(blockId);
+    for(std::size_t e=0;e<elements.size();e++) {
+      srcIndexer.getElementGIDs(elements[e],srcGids,blockId);
+      dstIndexer.getElementGIDs(elements[e],dstGids,blockId);
+
+      for(std::size_t i=0;i<dstOffsets.size();i++) {
+        int dstLid = dst.Map().LID(dstGids[dstOffsets[i]]);
+        if(dstLid<0)
+          continue;
+
+        dst[dstLid] = ghostedSrc[ghostedMap.LID(srcGids[srcOffsets[i]])];
+      }
+    }
+  }
+}
+
+//**********************************************************************
+void writeFieldToMesh(const panzer::UniqueGlobalIndexer<int,int> & indexer,
+                      const std::string & field,
+                      const Epetra_Vector & x,
+                      const std::string & meshField,
+                      panzer_stk::STK_Interface & mesh)
+{
+  const int fieldNum = indexer.getFieldNum(field);
+  TEUCHOS_TEST_FOR_EXCEPTION(fieldNum<0,std::logic_error,
+                             "writeFieldToMesh: field \"" << field << "\" does not exist!");
+
+  // ghost x so every DOF of a local element is available
+  std::vector<int> ghostedGids;
+  indexer.getOwnedAndGhostedIndices(ghostedGids);
+  Epetra_Map ghostedMap(-1,ghostedGids.size(),ghostedGids.size()>0 ? &ghostedGids[0] : 0,0,x.Comm());
+  Epetra_Import importer(ghostedMap,x.Map());
+  Epetra_Vector ghostedX(ghostedMap);
+  ghostedX.Import(x,importer,Insert);
+
+  std::vector<std::string> elementBlockIds;
+  indexer.getElementBlockIds(elementBlockIds);
+
+  // the offsets are in basis order, which for a nodal basis is the node order of the cell
+  std::vector<int> gids;
+  for(std::size_t eb=0;eb<elementBlockIds.size();eb++) {
+    const std::string & blockId = elementBlockIds[eb];
+
+    const std::vector<int> & offsets = indexer.getGIDFieldOffsets(blockId,fieldNum);
+    if(offsets.size()==0)
+      continue;
+
+    const std::vector<int> & elements = indexer.getElementBlock(blockId);
+    std::vector<std::size_t> localElementIds(elements.begin(),elements.end());
+    Kokkos::DynRankView<double,PHX::Device> values("values",elements.size(),offsets.size());
+    for(std::size_t e=0;e<elements.size();e++) {
+      indexer.getElementGIDs(elements[e],gids,blockId);
+      for(std::size_t i=0;i<offsets.size();i++)
+        values(e,i) = ghostedX[ghostedMap.LID(gids[offsets[i]])];
+    }
+
+    mesh.setSolutionFieldData(meshField,blockId,localElementIds,values);
+  }
+}
+
+}
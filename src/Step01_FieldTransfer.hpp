@@ -0,0 +1,42 @@
+#ifndef __Step01_FieldTransfer_hpp__
+#define __Step01_FieldTransfer_hpp__
+
+#include <string>
+
+#include "Panzer_UniqueGlobalIndexer.hpp"
+
+class Epetra_Vector;
+
+namespace panzer_stk {
+class STK_Interface;
+}
+
+namespace user_app {
+
+/** Copy the coefficients of field <code>srcField</code> in <code>src</code> into
+  * field <code>dstField</code> of <code>dst</code>.
+  *
+  * The two indexers may differ (e.g. a time domain model and a harmonic balance
+  * model), but must be built over the same mesh connectivity and use the same
+  * basis for the two fields. Only entries owned by <code>dst</code> are written.
+  */
+void copyFieldValues(const panzer::UniqueGlobalIndexer<int,int> & srcIndexer,
+                     const std::string & srcField,
+                     const Epetra_Vector & src,
+                     const panzer::UniqueGlobalIndexer<int,int> & dstIndexer,
+                     const std::string & dstField,
+                     Epetra_Vector & dst);
+
+/** Write the coefficients of field <code>field</code> in <code>x</code> to the
+  * nodal solution field <code>meshField</code> of <code>mesh</code>, which need
+  * not be a DOF of <code>indexer</code>. The field must use a nodal basis.
+  */
+void writeFieldToMesh(const panzer::UniqueGlobalIndexer<int,int> & indexer,
+                      const std::string & field,
+                      const Epetra_Vector & x,
+                      const std::string & meshField,
+                      panzer_stk::STK_Interface & mesh);
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "Step01_FiniteDifferenceJacobianOp.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include "Teuchos_Assert.hpp"
+
+#include "Thyra_MultiVectorStdOps.hpp"
+#include "Thyra_VectorStdOps.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+FiniteDifferenceJacobianOp::
+FiniteDifferenceJacobianOp(const Teuchos::RCP<const Thyra::ModelEvaluator<double> > & model)
+  : model_(model)
+  , num_evaluations_(0)
+{
+  x_perturbed_ = Thyra::createMember(model_->get_x_space());
+  f_perturbed_ = Thyra::createMember(model_->get_f_space());
+}
+
+//**********************************************************************
+void FiniteDifferenceJacobianOp::
+setBasePoint(const Teuchos::RCP<const Thyra::VectorBase<double> > & x,
+             const Teuchos::RCP<const Thyra::VectorBase<double> > & f)
+{
+  x_ = x;
+  f_ = f;
+}
+
+//**********************************************************************
+void FiniteDifferenceJacobianOp::
+applyImpl(const Thyra::EOpTransp M_trans,
+          const Thyra::MultiVectorBase<double> & X,
+          const Teuchos::Ptr<Thyra::MultiVectorBase<double> > & Y,
+          const double alpha,
+          const double beta) const
+{
+  TEUCHOS_ASSERT(M_trans==Thyra::NOTRANS);
+  TEUCHOS_TEST_FOR_EXCEPTION(x_==Teuchos::null,std::logic_error,
+                             "FiniteDifferenceJacobianOp: no base point, call setBasePoint first!");
+
+  const double x_norm = Thyra::norm_2(*x_);
+
+  for(int j=0;j<X.domain()->dim();j++) {
+    Teuchos::RCP<const Thyra::VectorBase<double> > v = X.col(j);
+    Teuchos::RCP<Thyra::VectorBase<double> > y = Y->col(j);
+
+    const double v_norm = Thyra::norm_2(*v);
+    if(v_norm==0.0) {
+      if(beta==0.0)
+        Thyra::assign(y.ptr(),0.0);
+      else
+        Thyra::Vt_S(y.ptr(),beta);
+      continue;
+    }
+
+    const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon()*(1.0+x_norm))/v_norm;
+
+    // f(x + eps v)
+    Thyra::V_VpStV(x_perturbed_.ptr(),*x_,epsilon,*v);
+    {
+      Thyra::ModelEvaluatorBase::InArgs<double> inArgs = model_->createInArgs();
+      inArgs.set_x(x_perturbed_);
+
+      Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = model_->createOutArgs();
+      outArgs.set_f(f_perturbed_);
+
+      model_->evalModel(inArgs,outArgs);
+      num_evaluations_++;
+    }
+
+    // y = alpha (f(x + eps v) - f(x))/eps + beta y
+    Thyra::Vp_StV(f_perturbed_.ptr(),-1.0,*f_);
+    if(beta==0.0)
+      Thyra::V_StV(y.ptr(),alpha/epsilon,*f_perturbed_);
+    else {
+      Thyra::Vt_S(y.ptr(),beta);
+      Thyra::Vp_StV(y.ptr(),alpha/epsilon,*f_perturbed_);
+    }
+  }
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef __Step01_FiniteDifferenceJacobianOp_hpp__
+#define __Step01_FiniteDifferenceJacobianOp_hpp__
+
+#include "Teuchos_RCP.hpp"
+
+#include "Thyra_LinearOpDefaultBase.hpp"
+#include "Thyra_ModelEvaluator.hpp"
+
+namespace user_app {
+
+/** A one sided finite difference approximation of the Jacobian of a model
+  * evaluator at a point, applied without a matrix.
+  *
+  * Every application replaces \f$J v\f$ by
+  * \f[ J v \approx \frac{f(x + \epsilon v) - f(x)}{\epsilon},
+  *     \qquad \epsilon = \frac{\sqrt{\varepsilon_{mach}(1+\|x\|)}}{\|v\|}, \f]
+  * i.e. one residual assembly per Krylov iteration and no storage beyond a
+  * few vectors. This is not the exact product: truncation and rounding leave
+  * a relative error of order \f$\sqrt{\varepsilon_{mach}}\f$, so the Newton
+  * iteration driven by it is an inexact one. The base point and its residual
+  * are set before each solve.
+  */
+class FiniteDifferenceJacobianOp : public Thyra::LinearOpDefaultBase<double> {
+public:
+
+  FiniteDifferenceJacobianOp(const Teuchos::RCP<const Thyra::ModelEvaluator<double> > & model);
+
+  /** Linearize about <code>x</code>; <code>f</code> is the residual there. Both
+    * are held by reference and must not change while the operator is applied.
+    */
+  void setBasePoint(const Teuchos::RCP<const Thyra::VectorBase<double> > & x,
+                    const Teuchos::RCP<const Thyra::VectorBase<double> > & f);
+
+  //! Residual assemblies done by the applications so far
+  int numResidualEvaluations() const
+  { return num_evaluations_; }
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > range() const
+  { return model_->get_f_space(); }
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > domain() const
+  { return model_->get_x_space(); }
+
+protected:
+
+  bool opSupportedImpl(Thyra::EOpTransp M_trans) const
+  { return M_trans==Thyra::NOTRANS; }
+
+  void applyImpl(const Thyra::EOpTransp M_trans,
+                 const Thyra::MultiVectorBase<double> & X,
+                 const Teuchos::Ptr<Thyra::MultiVectorBase<double> > & Y,
+                 const double alpha,
+                 const double beta) const;
+
+private:
+
+  Teuchos::RCP<const Thyra::ModelEvaluator<double> > model_;
+
+  Teuchos::RCP<const Thyra::VectorBase<double> > x_;
+  Teuchos::RCP<const Thyra::VectorBase<double> > f_;
+
+  // perturbed point and its residual
+  Teuchos::RCP<Thyra::VectorBase<double> > x_perturbed_;
+  Teuchos::RCP<Thyra::VectorBase<double> > f_perturbed_;
+
+  mutable int num_evaluations_;
+};
+
+}
+
+#endif
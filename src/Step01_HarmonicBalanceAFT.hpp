@@ -0,0 +1,94 @@
+#ifndef __Step01_HarmonicBalanceAFT_hpp__
+#define __Step01_HarmonicBalanceAFT_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_BatchedRealFFT.hpp"
+#include "Step01_HarmonicLayout.hpp"
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+    
+/** Alternating frequency/time evaluation of a nonlinear term for harmonic balance.
+  *
+  * The harmonic coefficients (0th mode, then the cosine/sine pair of every harmonic
+  * k = 1..M) are gathered at the integration points of the whole workset, synthesized
+  * into time samples over one period with a batched real FFT, passed through the
+  * nonlinearity \f$g(u) = c u^3\f$ and transformed back. The results are the harmonic
+  * coefficients of \f$g\f$, one field per harmonic DOF, to be integrated against the
+  * basis like any other residual term. Alternatively the coefficients and the result
+  * are single fields in the (Cell,Harmonic,Point) layout.
+  */
+template<typename EvalT, typename Traits>
+class HarmonicBalanceAFT : public PHX::EvaluatorWithBaseImpl<Traits>,
+                           public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    /** \param[in] dof_names Harmonic DOFs: 0th mode, cos 1, sin 1, ..., cos M, sin M
+      * \param[in] term_names Names of the evaluated fields, same ordering
+      * \param[in] coefficient Coefficient \f$c\f$ of the cubic term
+      * \param[in] time_samples Samples per period, a power of two larger than 2M
+      */
+    HarmonicBalanceAFT(const std::vector<std::string> & dof_names,
+                       const std::vector<std::string> & term_names,
+                       double coefficient,int time_samples,
+                       const panzer::IntegrationRule & ir);
+
+    /** \param[in] coefficient_name (Cell,Harmonic,Point) harmonic coefficients, ordered as above
+      * \param[in] term_name Name of the evaluated field, same layout
+      * \param[in] num_dofs Extent of the harmonic dimension, 2M+1
+      */
+    HarmonicBalanceAFT(const std::string & coefficient_name,
+                       const std::string & term_name,
+                       int num_dofs,
+                       double coefficient,int time_samples,
+                       const panzer::IntegrationRule & ir);
+                                                                        
+    void postRegistrationSetup(typename Traits::SetupData d,           
+                               PHX::FieldManager<Traits>& fm);        
+                                                                     
+    void evaluateFields(typename Traits::EvalData d);               
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  double coefficient_;
+  int num_harmonics_;
+
+  BatchedRealFFT<ScalarT> fft_;
+
+  // harmonic coefficients of the solution and of the nonlinear term
+  std::vector<PHX::MDField<ScalarT,panzer::Cell,panzer::Point> > coefficients;
+  std::vector<PHX::MDField<ScalarT,panzer::Cell,panzer::Point> > terms;
+
+  // or the same in the harmonic layout
+  bool harmonic_layout_;
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point> harmonic_coefficients;
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point> harmonic_terms;
+
+  ScalarT coefficientValue(int i,int cell,int point) const
+  { return harmonic_layout_ ? ScalarT(harmonic_coefficients(cell,i,point)) : ScalarT(coefficients[i](cell,point)); }
+
+  void setTerm(int i,int cell,int point,const ScalarT & value)
+  {
+    if(harmonic_layout_)
+      harmonic_terms(cell,i,point) = value;
+    else
+      terms[i](cell,point) = value;
+  }
+
+  // workset sized scratch: half spectrum and time samples
+  std::vector<ScalarT> spectrum_re_, spectrum_im_, samples_;
+};
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef __Step01_HarmonicBalanceAFT_impl_hpp__
+#define __Step01_HarmonicBalanceAFT_impl_hpp__
+
+#include "Teuchos_Assert.hpp"
+
+#include "Panzer_IntegrationRule.hpp"
+#include "Panzer_Workset.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+HarmonicBalanceAFT<EvalT,Traits>::HarmonicBalanceAFT(const std::vector<std::string> & dof_names,
+                                                     const std::vector<std::string> & term_names,
+                                                     double coefficient,int time_samples,
+                                                     const panzer::IntegrationRule & ir)
+  : coefficient_(coefficient) 
+  , num_harmonics_((dof_names.size()-1)/2)
+  , fft_(time_samples)
+  , harmonic_layout_(false)
+{
+  TEUCHOS_ASSERT(dof_names.size()==term_names.size());
+  TEUCHOS_ASSERT(dof_names.size()%2==1);
+  TEUCHOS_TEST_FOR_EXCEPTION(time_samples<=2*num_harmonics_,std::logic_error,
+                             "HarmonicBalanceAFT: " << time_samples << " time samples cannot resolve "
+                             << num_harmonics_ << " harmonics!");
+
+  Teuchos::RCP<PHX::DataLayout> data_layout = ir.dl_scalar;
+
+  for(std::size_t i=0;i<dof_names.size();i++) {
+    coefficients.push_back(PHX::MDField<ScalarT,panzer::Cell,panzer::Point>(dof_names[i], data_layout));
+    this->addDependentField(coefficients.back());
+
+    terms.push_back(PHX::MDField<ScalarT,panzer::Cell,panzer::Point>(term_names[i], data_layout));
+    this->addEvaluatedField(terms.back());
+  }
+
+  this->setName("Harmonic Balance AFT("+dof_names[0]+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+HarmonicBalanceAFT<EvalT,Traits>::HarmonicBalanceAFT(const std::string & coefficient_name,
+                                                     const std::string & term_name,
+                                                     int num_dofs,
+                                                     double coefficient,int time_samples,
+                                                     const panzer::IntegrationRule & ir)
+  : coefficient_(coefficient) 
+  , num_harmonics_((num_dofs-1)/2)
+  , fft_(time_samples)
+  , harmonic_layout_(true)
+{
+  TEUCHOS_ASSERT(num_dofs%2==1);
+  TEUCHOS_TEST_FOR_EXCEPTION(time_samples<=2*num_harmonics_,std::logic_error,
+                             "HarmonicBalanceAFT: " << time_samples << " time samples cannot resolve "
+                             << num_harmonics_ << " harmonics!");
+
+  Teuchos::RCP<PHX::DataLayout> data_layout = buildHarmonicScalarLayout(ir,num_dofs);
+
+  harmonic_coefficients = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point>(coefficient_name, data_layout);
+  this->addDependentField(harmonic_coefficients);
+
+  harmonic_terms = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point>(term_name, data_layout);
+  this->addEvaluatedField(harmonic_terms);
+
+  this->setName("Harmonic Balance AFT("+coefficient_name+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicBalanceAFT<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,           
+                                                             PHX::FieldManager<Traits>& fm)
+{
+  for(std::size_t i=0;i<coefficients.size();i++) {
+    this->utils.setFieldData(coefficients[i],fm);
+    this->utils.setFieldData(terms[i],fm);
+  }
+  if(harmonic_layout_) {
+    this->utils.setFieldData(harmonic_coefficients,fm);
+    this->utils.setFieldData(harmonic_terms,fm);
+  }
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicBalanceAFT<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{ 
+  const int num_points = harmonic_layout_ ? harmonic_coefficients.extent_int(2) : coefficients[0].extent_int(1);
+  const int batch = workset.num_cells*num_points;
+  const int n = fft_.size();
+  const int h = n/2;
+
+  if(batch==0)
+    return;
+
+  // copy the AD type from the first field, so the scratch carries the right derivative length
+  const ScalarT zero = 0.0*coefficientValue(0,0,0);
+
+  spectrum_re_.assign((h+1)*batch,zero);
+  spectrum_im_.assign((h+1)*batch,zero);
+  samples_.resize(n*batch);
+
+  // gather: u = a_0 + sum_k a_k cos + b_k sin  <=>  X_0 = a_0, X_k = (a_k - i b_k)/2
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+    for (int point = 0; point < num_points; ++point) {
+      const int b = cell*num_points+point;
+      spectrum_re_[b] = coefficientValue(0,cell,point);
+      for (int k = 1; k <= num_harmonics_; ++k) {
+        spectrum_re_[k*batch+b] =  0.5*coefficientValue(2*k-1,cell,point);
+        spectrum_im_[k*batch+b] = -0.5*coefficientValue(2*k,cell,point);
+      }
+    }
+  }
+
+  // synthesize the time samples of every point in the workset
+  fft_.inverse(&spectrum_re_[0],&spectrum_im_[0],&samples_[0],batch);
+
+  // evaluate the time domain nonlinearity
+  for (int i = 0; i < n*batch; ++i)
+    samples_[i] = coefficient_*samples_[i]*samples_[i]*samples_[i];
+
+  // and transform back to harmonic coefficients
+  fft_.forward(&samples_[0],&spectrum_re_[0],&spectrum_im_[0],batch);
+
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+    for (int point = 0; point < num_points; ++point) {
+      const int b = cell*num_points+point;
+      setTerm(0,cell,point,spectrum_re_[b]/n);
+      for (int k = 1; k <= num_harmonics_; ++k) {
+        setTerm(2*k-1,cell,point, 2.0*spectrum_re_[k*batch+b]/n);
+        setTerm(2*k,cell,point,  -2.0*spectrum_im_[k*batch+b]/n);
+      }
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
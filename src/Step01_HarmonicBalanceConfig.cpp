@@ -0,0 +1,91 @@
+#include "Step01_HarmonicBalanceConfig.hpp"
+
+#include "Teuchos_Assert.hpp"
+#include "Teuchos_Array.hpp"
+#include "Teuchos_StandardParameterEntryValidators.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+HarmonicBalanceConfig::
+HarmonicBalanceConfig(Teuchos::ParameterList & eqset_params)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(!eqset_params.isSublist("FreqDom Options"),std::logic_error,
+                             "Error - Equation set \"FreqDom\" chosen, but missing a \"FreqDom Options\" parameter sublist!");
+  Teuchos::ParameterList & freqdom_pl = eqset_params.sublist("FreqDom Options");
+
+  // ********************
+  // Validate the FreqDom Options
+  // ********************
+  {
+    Teuchos::ParameterList freqdom_opt;
+    Teuchos::setStringToIntegralParameter<int>(
+      "Time domain equation set",
+      "Projection", // default gives an invalid type
+      "Choose the time domain equation set to model in the frequency domain",
+      Teuchos::tuple<std::string>("Helmholtz", "Projection"),
+      &freqdom_opt
+      );
+    freqdom_opt.set("Truncation order",3,"Truncation order of the harmonic balance method.");
+    freqdom_opt.set("Fundamental frequencies",Teuchos::Array<double>(1,1.0),
+                    "Fundamental frequencies (cycles per unit time) of the (quasi-)periodic response.");
+    Teuchos::setStringToIntegralParameter<TruncationScheme>(
+      "Truncation scheme",
+      "Box",
+      "Which harmonics of the fundamental frequencies are retained, up to the truncation order",
+      Teuchos::tuple<std::string>("Box", "Diamond", "Alpha"),
+      Teuchos::tuple<TruncationScheme>(TRUNCATION_BOX, TRUNCATION_DIAMOND, TRUNCATION_ALPHA),
+      &freqdom_opt
+      );
+    freqdom_opt.set("Truncation alpha",0.5,"Exponent alpha of the l^alpha ball used by the \"Alpha\" truncation scheme.");
+    freqdom_opt.set("Nonlinear reaction coefficient",0.0,"Coefficient c of a c*u^3 reaction term, evaluated by alternating frequency/time.");
+    freqdom_opt.set("AFT time samples",0,"Time samples per period for the AFT evaluation, a power of two (0 picks the alias free size).");
+
+    freqdom_pl.validateParametersAndSetDefaults(freqdom_opt);
+  }
+
+  time_domain_eqset_       = freqdom_pl.get<std::string>("Time domain equation set");
+  fundamental_frequencies_ = freqdom_pl.get<Teuchos::Array<double> >("Fundamental frequencies").toVector();
+  truncation_order_        = freqdom_pl.get<int>("Truncation order");
+  truncation_scheme_       = Teuchos::getIntegralValue<TruncationScheme>(freqdom_pl,"Truncation scheme");
+  truncation_alpha_        = freqdom_pl.get<double>("Truncation alpha");
+  nonlinear_coefficient_   = freqdom_pl.get<double>("Nonlinear reaction coefficient");
+  aft_time_samples_        = freqdom_pl.get<int>("AFT time samples");
+
+  // the AFT evaluation transforms over a single period
+  TEUCHOS_TEST_FOR_EXCEPTION(nonlinear_coefficient_!=0.0 && fundamental_frequencies_.size()!=1,std::logic_error,
+                             "Error - the FreqDom nonlinear reaction term supports a single fundamental frequency only.");
+
+  // a cubic term creates harmonics up to 3M, which must not alias onto the retained 0..M
+  if(aft_time_samples_==0) {
+    aft_time_samples_ = 2;
+    while(aft_time_samples_ <= 4*truncation_order_)
+      aft_time_samples_ *= 2;
+  }
+
+  // ********************
+  // Harmonic layout
+  // ********************
+
+  // the harmonics k (one per +/-k pair) kept by the truncation scheme; with a single
+  // fundamental frequency every scheme keeps k = 1..truncation order
+  buildHarmonicIndexSet(fundamental_frequencies_.size(),truncation_order_,
+                        truncation_scheme_,truncation_alpha_,harmonics_);
+
+  // the 0th mode is named as the DOF of the time domain equation set
+  mean_dof_name_ = eqset_params.get<std::string>("Prefix","")+"U";
+  dof_names_.push_back(mean_dof_name_);
+
+  for(std::size_t h=0;h<harmonics_.size();h++) {
+    const double frequency = harmonicFrequency(harmonics_[h],fundamental_frequencies_);
+    const std::string harmonic = mean_dof_name_ + harmonicSuffix(harmonics_[h]);
+
+    harmonic_dof_names_.push_back(harmonic+"_cos");
+    harmonic_dof_names_.push_back(harmonic+"_sin");
+    harmonic_dof_frequencies_.push_back(frequency);
+    harmonic_dof_frequencies_.push_back(frequency);
+  }
+  dof_names_.insert(dof_names_.end(),harmonic_dof_names_.begin(),harmonic_dof_names_.end());
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef __Step01_HarmonicBalanceConfig_hpp__
+#define __Step01_HarmonicBalanceConfig_hpp__
+
+#include <string>
+#include <vector>
+
+#include "Teuchos_ParameterList.hpp"
+
+#include "Step01_HarmonicIndexSet.hpp"
+
+namespace user_app {
+
+/** The parsed "FreqDom Options" of a FreqDom equation set: frequencies, the
+  * retained harmonics and the names of the harmonic DOFs.
+  *
+  * Built once per equation set by the EquationSetFactory and shared (const)
+  * by the equation set of every evaluation type, so no evaluation type parses
+  * or reads input on its own. The driver builds the same object to find out
+  * the harmonic layout of the problem it solves.
+  */
+class HarmonicBalanceConfig {
+public:
+
+  /** Validates the "FreqDom Options" sublist of <code>eqset_params</code>,
+    * filling in defaults, and builds the harmonic layout from it.
+    */
+  HarmonicBalanceConfig(Teuchos::ParameterList & eqset_params);
+
+  //! Name of the equation set modeled in the frequency domain
+  const std::string & timeDomainEquationSet() const
+  { return time_domain_eqset_; }
+
+  //! Fundamental frequencies, cycles per unit time
+  const std::vector<double> & fundamentalFrequencies() const
+  { return fundamental_frequencies_; }
+
+  int truncationOrder() const
+  { return truncation_order_; }
+
+  TruncationScheme truncationScheme() const
+  { return truncation_scheme_; }
+
+  double truncationAlpha() const
+  { return truncation_alpha_; }
+
+  //! Retained harmonics, one multi-index per +/-k pair
+  const std::vector<std::vector<int> > & harmonics() const
+  { return harmonics_; }
+
+  //! The 0th mode DOF, named as in the time domain equation set
+  const std::string & meanDOFName() const
+  { return mean_dof_name_; }
+
+  /** Harmonic DOFs as cosine/sine pairs: entry <code>2*h</code> is the cosine
+    * coefficient of <code>harmonics()[h]</code>, entry <code>2*h+1</code> the sine
+    * coefficient.
+    */
+  const std::vector<std::string> & harmonicDOFNames() const
+  { return harmonic_dof_names_; }
+
+  //! Frequency (cycles per unit time) of the harmonic each harmonic DOF belongs to
+  const std::vector<double> & harmonicDOFFrequencies() const
+  { return harmonic_dof_frequencies_; }
+
+  //! All DOFs, the 0th mode first
+  const std::vector<std::string> & dofNames() const
+  { return dof_names_; }
+
+  //! Coefficient c of the c*u^3 reaction term
+  double nonlinearCoefficient() const
+  { return nonlinear_coefficient_; }
+
+  //! Time samples per period of the AFT evaluation (resolved if the input asks for the automatic size)
+  int aftTimeSamples() const
+  { return aft_time_samples_; }
+
+private:
+
+  std::string time_domain_eqset_;
+  std::vector<double> fundamental_frequencies_;
+  int truncation_order_;
+  TruncationScheme truncation_scheme_;
+  double truncation_alpha_;
+  std::vector<std::vector<int> > harmonics_;
+
+  std::string mean_dof_name_;
+  std::vector<std::string> harmonic_dof_names_;
+  std::vector<double> harmonic_dof_frequencies_;
+  std::vector<std::string> dof_names_;
+
+  double nonlinear_coefficient_;
+  int aft_time_samples_;
+};
+
+}
+
+#endif
@@ -0,0 +1,361 @@
+#include "Step01_HarmonicBlockSolver.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Teuchos_Assert.hpp"
+#include "Teuchos_DefaultMpiComm.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Import.h"
+#include "Epetra_IntVector.h"
+#include "Epetra_Map.h"
+#include "Epetra_MpiComm.h"
+#include "Epetra_Vector.h"
+
+#include "Thyra_EpetraLinearOp.hpp"
+#include "Thyra_EpetraThyraWrappers.hpp"
+#include "Thyra_LinearOpWithSolveFactoryHelpers.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+HarmonicBlockSolver::
+HarmonicBlockSolver(const Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > & dofManager,
+                    const Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > & lowsFactory,
+                    bool useSubCommunicators)
+  : dofManager_(dofManager)
+  , lowsFactory_(lowsFactory)
+  , useSubCommunicators_(useSubCommunicators)
+  , group_(0)
+{
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+buildFieldMap(std::map<int,int> & gidToField) const
+{
+  std::vector<std::string> elementBlockIds;
+  dofManager_->getElementBlockIds(elementBlockIds);
+
+  std::vector<int> gids;
+  for(std::size_t eb=0;eb<elementBlockIds.size();eb++) {
+    const std::string & blockId = elementBlockIds[eb];
+    const std::vector<int> & elements = dofManager_->getElementBlock(blockId);
+
+    for(int field=0;field<dofManager_->getNumFields();field++) {
+      const std::vector<int> & offsets = dofManager_->getGIDFieldOffsets(blockId,field);
+      if(offsets.size()==0)
+        continue;
+
+      for(std::size_t e=0;e<elements.size();e++) {
+        dofManager_->getElementGIDs(elements[e],gids,blockId);
+        for(std::size_t i=0;i<offsets.size();i++)
+          gidToField[gids[offsets[i]]] = field;
+      }
+    }
+  }
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+findFieldBlocks(const Epetra_CrsMatrix & A,
+                const std::map<int,int> & gidToField,
+                std::vector<int> & fieldToBlock) const
+{
+  const int numFields = dofManager_->getNumFields();
+
+  // mark every pair of fields coupled by a (numerically) nonzero entry
+  std::vector<int> localCoupled(numFields*numFields,0);
+  for(int row=0;row<A.NumMyRows();row++) {
+    int numEntries = 0;
+    double * values = 0;
+    int * indices = 0;
+    A.ExtractMyRowView(row,numEntries,values,indices);
+
+    const int rowField = gidToField.find(A.GRID(row))->second;
+    for(int j=0;j<numEntries;j++) {
+      if(values[j]==0.0)
+        continue;
+
+      std::map<int,int>::const_iterator colItr = gidToField.find(A.GCID(indices[j]));
+      TEUCHOS_ASSERT(colItr!=gidToField.end());
+      localCoupled[rowField*numFields+colItr->second] = 1;
+    }
+  }
+
+  std::vector<int> coupled(numFields*numFields,0);
+  A.Comm().MaxAll(&localCoupled[0],&coupled[0],numFields*numFields);
+
+  // connected components of the coupling graph (union find)
+  std::vector<int> parent(numFields);
+  for(int f=0;f<numFields;f++)
+    parent[f] = f;
+
+  for(int fi=0;fi<numFields;fi++) {
+    for(int fj=0;fj<numFields;fj++) {
+      if(!coupled[fi*numFields+fj])
+        continue;
+
+      int ri = fi, rj = fj;
+      while(parent[ri]!=ri) ri = parent[ri];
+      while(parent[rj]!=rj) rj = parent[rj];
+      if(ri!=rj)
+        parent[std::max(ri,rj)] = std::min(ri,rj);
+    }
+  }
+
+  std::map<int,int> rootToBlock;
+  fieldToBlock.resize(numFields);
+  for(int f=0;f<numFields;f++) {
+    int root = f;
+    while(parent[root]!=root) root = parent[root];
+
+    if(rootToBlock.find(root)==rootToBlock.end()) {
+      int block = rootToBlock.size();
+      rootToBlock[root] = block;
+    }
+    fieldToBlock[f] = rootToBlock[root];
+  }
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+distributeBlock(const Epetra_CrsMatrix & A,int group,Block & block) const
+{
+  using Teuchos::rcp;
+
+  // number the block rows 0..N-1 in rank order, then hand out contiguous
+  // slices of that numbering to the ranks of the group; importing the GIDs
+  // along the numbering tells every rank of the group which rows it gets
+  const int numMyRows = block.ownedMap->NumMyElements();
+  const int numRows = block.ownedMap->NumGlobalElements();
+  const int subRank = subComm_->getRank();
+  const int subSize = subComm_->getSize();
+  const int numTargetRows = (group_==group)
+      ? int((long long)numRows*(subRank+1)/subSize-(long long)numRows*subRank/subSize) : 0;
+
+  Epetra_Map sourceNumbering(numRows,numMyRows,0,A.Comm());
+  Epetra_Map targetNumbering(numRows,numTargetRows,0,A.Comm());
+  Epetra_IntVector sourceGids(View,sourceNumbering,block.ownedMap->MyGlobalElements());
+  Epetra_IntVector targetGids(targetNumbering);
+  targetGids.Import(sourceGids,Epetra_Import(targetNumbering,sourceNumbering),Insert);
+
+  block.map = rcp(new Epetra_Map(-1,numTargetRows,targetGids.Values(),0,A.Comm()));
+  block.distributor = rcp(new Epetra_Import(*block.map,*block.ownedMap));
+
+  // the same rows on the group's communicator, every column of the block is a row in the group
+  block.solveMap = Teuchos::null;
+  if(group_==group)
+    block.solveMap = rcp(new Epetra_Map(-1,numTargetRows,targetGids.Values(),0,*epetraSubComm_));
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+copyBlockValues(const Epetra_CrsMatrix & A,int b)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  Block & block = blocks_[b];
+
+  // copy the diagonal block out of the full matrix
+  RCP<Epetra_CrsMatrix> owned = rcp(new Epetra_CrsMatrix(Copy,*block.ownedMap,0));
+  {
+    std::vector<double> values(std::max(A.MaxNumEntries(),1));
+    std::vector<int> indices(values.size());
+    std::vector<double> blockValues(values.size());
+    std::vector<int> blockIndices(values.size());
+    for(int r=0;r<block.ownedMap->NumMyElements();r++) {
+      const int gid = block.ownedMap->GID(r);
+      int numEntries = 0;
+      A.ExtractGlobalRowCopy(gid,values.size(),numEntries,&values[0],&indices[0]);
+
+      int numBlockEntries = 0;
+      for(int j=0;j<numEntries;j++) {
+        if(fieldToBlock_[gidToField_[indices[j]]]!=b) {
+          TEUCHOS_TEST_FOR_EXCEPTION(values[j]!=0.0,std::runtime_error,
+                                     "HarmonicBlockSolver: the matrix couples blocks that were decoupled at initialize()!");
+          continue;
+        }
+
+        blockValues[numBlockEntries] = values[j];
+        blockIndices[numBlockEntries] = indices[j];
+        numBlockEntries++;
+      }
+
+      owned->InsertGlobalValues(gid,numBlockEntries,&blockValues[0],&blockIndices[0]);
+    }
+    owned->FillComplete();
+  }
+
+  RCP<Epetra_CrsMatrix> source = owned;
+  if(block.distributor!=Teuchos::null) {
+    source = rcp(new Epetra_CrsMatrix(Copy,*block.map,0));
+    source->Import(*owned,*block.distributor,Insert);
+    source->FillComplete();
+  }
+
+  if(block.solveMap==Teuchos::null)
+    return;
+
+  // the rows of the solve map are the rows of source, on the communicator that solves the block
+  const bool insert = (block.matrix==Teuchos::null);
+  if(insert)
+    block.matrix = rcp(new Epetra_CrsMatrix(Copy,*block.solveMap,0));
+
+  std::vector<double> values(std::max(source->MaxNumEntries(),1));
+  std::vector<int> indices(values.size());
+  for(int row=0;row<block.solveMap->NumMyElements();row++) {
+    const int gid = block.solveMap->GID(row);
+    int numEntries = 0;
+    source->ExtractGlobalRowCopy(gid,values.size(),numEntries,&values[0],&indices[0]);
+    if(insert)
+      block.matrix->InsertGlobalValues(gid,numEntries,&values[0],&indices[0]);
+    else {
+      const int err = block.matrix->ReplaceGlobalValues(gid,numEntries,&values[0],&indices[0]);
+      TEUCHOS_TEST_FOR_EXCEPTION(err!=0,std::runtime_error,
+                                 "HarmonicBlockSolver: the matrix does not have the graph it had at initialize()!");
+    }
+  }
+  if(insert)
+    block.matrix->FillComplete();
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+initialize(const Epetra_CrsMatrix & A)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  gidToField_.clear();
+  buildFieldMap(gidToField_);
+  findFieldBlocks(A,gidToField_,fieldToBlock_);
+
+  int numBlocks = 0;
+  for(std::size_t f=0;f<fieldToBlock_.size();f++)
+    numBlocks = std::max(numBlocks,fieldToBlock_[f]+1);
+
+  blocks_.clear();
+  blocks_.resize(numBlocks);
+  for(std::size_t f=0;f<fieldToBlock_.size();f++)
+    blocks_[fieldToBlock_[f]].fields.push_back(dofManager_->getFieldString(f));
+
+  // one group of contiguous ranks per block, as long as there are ranks to spare
+  const int numProcs = A.Comm().NumProc();
+  const int numGroups = useSubCommunicators_ ? std::min(numProcs,numBlocks) : 1;
+  group_ = 0;
+  subComm_ = Teuchos::null;
+  epetraSubComm_ = Teuchos::null;
+  if(numGroups>1) {
+    const Epetra_MpiComm * mpiComm = dynamic_cast<const Epetra_MpiComm*>(&A.Comm());
+    TEUCHOS_TEST_FOR_EXCEPTION(mpiComm==0,std::logic_error,
+                               "HarmonicBlockSolver: sub-communicators need an Epetra_MpiComm!");
+
+    group_ = int((long long)A.Comm().MyPID()*numGroups/numProcs);
+    Teuchos::MpiComm<int> fullComm(Teuchos::opaqueWrapper(mpiComm->Comm()));
+    subComm_ = fullComm.split(group_,A.Comm().MyPID());
+    epetraSubComm_ = rcp(new Epetra_MpiComm(*Teuchos::rcp_dynamic_cast<const Teuchos::MpiComm<int> >(subComm_,true)->getRawMpiComm()));
+  }
+
+  // sort the owned rows into their blocks
+  std::vector<std::vector<int> > blockRows(numBlocks);
+  for(int row=0;row<A.NumMyRows();row++) {
+    int gid = A.GRID(row);
+    blockRows[fieldToBlock_[gidToField_[gid]]].push_back(gid);
+  }
+
+  for(int b=0;b<numBlocks;b++) {
+    Block & block = blocks_[b];
+    const std::vector<int> & rows = blockRows[b];
+
+    block.ownedMap = rcp(new Epetra_Map(-1,rows.size(),rows.size()>0 ? &rows[0] : 0,0,A.Comm()));
+    block.map = block.ownedMap;
+    block.solveMap = block.ownedMap;
+    if(numGroups>1)
+      distributeBlock(A,b%numGroups,block);
+    block.importer = rcp(new Epetra_Import(*block.map,A.RowMap()));
+
+    copyBlockValues(A,b);
+
+    if(block.matrix!=Teuchos::null) {
+      block.op = Thyra::epetraLinearOp(block.matrix);
+      block.lows = Thyra::linearOpWithSolve<double>(*lowsFactory_,block.op);
+    }
+  }
+
+  if(A.Comm().MyPID()==0) {
+    std::cout << "Harmonic block solver found " << numBlocks << " decoupled block(s)";
+    if(numGroups>1)
+      std::cout << ", solved by " << numGroups << " groups of ranks";
+    std::cout << ":" << std::endl;
+    for(int b=0;b<numBlocks;b++) {
+      std::cout << "   block " << b;
+      if(numGroups>1)
+        std::cout << " (group " << b%numGroups << ")";
+      std::cout << ":";
+      for(std::size_t f=0;f<blocks_[b].fields.size();f++)
+        std::cout << " " << blocks_[b].fields[f];
+      std::cout << std::endl;
+    }
+  }
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+updateValues(const Epetra_CrsMatrix & A)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(blocks_.size()==0,std::logic_error,
+                             "HarmonicBlockSolver::updateValues: initialize() has not been called!");
+
+  for(int b=0;b<int(blocks_.size());b++) {
+    copyBlockValues(A,b);
+
+    Block & block = blocks_[b];
+    if(block.lows!=Teuchos::null)
+      Thyra::initializeOp<double>(*lowsFactory_,block.op,block.lows.ptr());
+  }
+}
+
+//**********************************************************************
+void HarmonicBlockSolver::
+solve(const Epetra_Vector & b,Epetra_Vector & x) const
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  TEUCHOS_TEST_FOR_EXCEPTION(blocks_.size()==0,std::logic_error,
+                             "HarmonicBlockSolver::solve: initialize() has not been called!");
+
+  const int numBlocks = blocks_.size();
+  std::vector<RCP<Epetra_Vector> > blockRhs(numBlocks), blockSolutions(numBlocks);
+  for(int i=0;i<numBlocks;i++) {
+    blockRhs[i] = rcp(new Epetra_Vector(*blocks_[i].map));
+    blockRhs[i]->Import(b,*blocks_[i].importer,Insert);
+    blockSolutions[i] = rcp(new Epetra_Vector(*blocks_[i].map));
+  }
+
+  // every rank only solves the blocks of its group, so the groups work concurrently;
+  // the block vectors already hold exactly the rows of the solve map
+  for(int i=0;i<numBlocks;i++) {
+    const Block & block = blocks_[i];
+    if(block.lows==Teuchos::null)
+      continue;
+
+    RCP<Epetra_Vector> rhs = rcp(new Epetra_Vector(View,*block.solveMap,blockRhs[i]->Values()));
+    RCP<Epetra_Vector> solution = rcp(new Epetra_Vector(View,*block.solveMap,blockSolutions[i]->Values()));
+
+    RCP<const Thyra::VectorSpaceBase<double> > space = Thyra::create_VectorSpace(block.solveMap);
+    RCP<const Thyra::VectorBase<double> > th_b = Thyra::create_Vector(rhs.getConst(),space);
+    RCP<Thyra::VectorBase<double> > th_x = Thyra::create_Vector(solution,space);
+
+    block.lows->solve(Thyra::NOTRANS,*th_b,th_x.ptr());
+  }
+
+  for(int i=0;i<numBlocks;i++)
+    x.Export(*blockSolutions[i],*blocks_[i].importer,Insert);
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef __Step01_HarmonicBlockSolver_hpp__
+#define __Step01_HarmonicBlockSolver_hpp__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Teuchos_Comm.hpp"
+#include "Teuchos_RCP.hpp"
+
+#include "Thyra_LinearOpWithSolveBase.hpp"
+#include "Thyra_LinearOpWithSolveFactoryBase.hpp"
+
+#include "Panzer_UniqueGlobalIndexer.hpp"
+
+class Epetra_Comm;
+class Epetra_CrsMatrix;
+class Epetra_Import;
+class Epetra_Map;
+class Epetra_Vector;
+
+namespace user_app {
+
+/** Solves a harmonic balance system one decoupled block at a time.
+  *
+  * For a linear time domain equation set the harmonic balance Jacobian only
+  * couples the cosine and sine coefficients of the same harmonic. The blocks
+  * are found from the nonzero structure of the assembled operator (two fields
+  * share a block when any entry couples them), copied into their own Epetra
+  * matrices and handed to the linear solver separately.
+  *
+  * With sub-communicators enabled the ranks are split into as many groups as
+  * there are blocks (at most one group per rank), the blocks are dealt out to
+  * the groups round robin and every block is moved onto the ranks of its
+  * group, so the groups solve their blocks concurrently. Otherwise every
+  * block is solved in turn on the full communicator.
+  */
+class HarmonicBlockSolver {
+public:
+
+  HarmonicBlockSolver(const Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > & dofManager,
+                      const Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > & lowsFactory,
+                      bool useSubCommunicators);
+
+  /** Find the field blocks of <code>A</code> and build a solver for each one.
+    */
+  void initialize(const Epetra_CrsMatrix & A);
+
+  /** Copy the values of <code>A</code>, which has the graph and block structure
+    * of the matrix passed to initialize(), into the blocks and set their solvers
+    * up again, e.g. once per Newton iteration.
+    */
+  void updateValues(const Epetra_CrsMatrix & A);
+
+  /** Solve <code>A x = b</code> block by block.
+    */
+  void solve(const Epetra_Vector & b,Epetra_Vector & x) const;
+
+  std::size_t numBlocks() const
+  { return blocks_.size(); }
+
+  const std::vector<std::string> & getBlockFields(std::size_t block) const
+  { return blocks_[block].fields; }
+
+private:
+
+  struct Block {
+    std::vector<std::string> fields;
+    // the block rows as the full system owns them
+    Teuchos::RCP<Epetra_Map> ownedMap;
+    // the block rows on the full communicator, and the import of them from the full system
+    Teuchos::RCP<Epetra_Map> map;
+    Teuchos::RCP<Epetra_Import> importer;
+    // the import from ownedMap to map, null when the block is not redistributed
+    Teuchos::RCP<Epetra_Import> distributor;
+    // the same rows on the communicator that solves the block, null on the ranks outside it
+    Teuchos::RCP<Epetra_Map> solveMap;
+    Teuchos::RCP<Epetra_CrsMatrix> matrix;
+    Teuchos::RCP<const Thyra::LinearOpBase<double> > op;
+    Teuchos::RCP<Thyra::LinearOpWithSolveBase<double> > lows;
+  };
+
+  // field number of every GID touched by a local element (owned and ghosted)
+  void buildFieldMap(std::map<int,int> & gidToField) const;
+
+  // group the fields into connected components of the field coupling graph
+  void findFieldBlocks(const Epetra_CrsMatrix & A,
+                       const std::map<int,int> & gidToField,
+                       std::vector<int> & fieldToBlock) const;
+
+  // lay the block out on the ranks of group <code>group</code>, spread evenly over them
+  void distributeBlock(const Epetra_CrsMatrix & A,int group,Block & block) const;
+
+  // copy the block of A into the block matrix, inserting on the first call and
+  // replacing values afterwards
+  void copyBlockValues(const Epetra_CrsMatrix & A,int b);
+
+  Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > dofManager_;
+  Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory_;
+  bool useSubCommunicators_;
+
+  // this rank's group and its communicator
+  int group_;
+  Teuchos::RCP<const Teuchos::Comm<int> > subComm_;
+  Teuchos::RCP<Epetra_Comm> epetraSubComm_;
+
+  std::map<int,int> gidToField_;
+  std::vector<int> fieldToBlock_;
+  std::vector<Block> blocks_;
+};
+
+}
+
+#endif
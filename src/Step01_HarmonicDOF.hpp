@@ -0,0 +1,62 @@
+#ifndef __Step01_HarmonicDOF_hpp__
+#define __Step01_HarmonicDOF_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_HarmonicLayout.hpp"
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** Interpolates the gathered harmonic balance DOFs to the integration points.
+  *
+  * Takes the basis coefficients of every harmonic DOF (as gathered by Panzer,
+  * (Cell,BASIS) each) and evaluates the values and the gradients of all of
+  * them in one pass over the workset, into a (Cell,Harmonic,Point) field and a
+  * (Cell,Harmonic,Point,Dim) field. This replaces the DOF and DOFGradient
+  * evaluators Panzer would otherwise run per harmonic.
+  */
+template<typename EvalT, typename Traits>
+class HarmonicDOF : public PHX::EvaluatorWithBaseImpl<Traits>,
+                    public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    /** \param[in] dof_names Harmonic DOFs: 0th mode, then the cosine/sine pairs
+      * \param[in] value_name Name of the (Cell,Harmonic,Point) values
+      * \param[in] gradient_name Name of the (Cell,Harmonic,Point,Dim) gradients
+      */
+    HarmonicDOF(const std::vector<std::string> & dof_names,
+                const std::string & value_name,
+                const std::string & gradient_name,
+                const panzer::BasisIRLayout & basis,
+                const panzer::IntegrationRule & ir);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  // gathered basis coefficients, one field per harmonic DOF
+  std::vector<PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> > coefficients;
+
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point> value;
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point,panzer::Dim> gradient;
+
+  std::string basis_name_;
+  std::size_t basis_index_;
+};
+
+}
+
+#endif
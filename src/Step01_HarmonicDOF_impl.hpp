@@ -0,0 +1,84 @@
+#ifndef __Step01_HarmonicDOF_impl_hpp__
+#define __Step01_HarmonicDOF_impl_hpp__
+
+#include "Panzer_BasisIRLayout.hpp"
+#include "Panzer_IntegrationRule.hpp"
+#include "Panzer_Workset.hpp"
+#include "Panzer_Workset_Utilities.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+HarmonicDOF<EvalT,Traits>::HarmonicDOF(const std::vector<std::string> & dof_names,
+                                       const std::string & value_name,
+                                       const std::string & gradient_name,
+                                       const panzer::BasisIRLayout & basis,
+                                       const panzer::IntegrationRule & ir)
+  : basis_name_(basis.name())
+{
+  for(std::size_t i=0;i<dof_names.size();i++) {
+    coefficients.push_back(PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS>(dof_names[i], basis.functional));
+    this->addDependentField(coefficients.back());
+  }
+
+  value = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point>(value_name, buildHarmonicScalarLayout(ir,dof_names.size()));
+  this->addEvaluatedField(value);
+
+  gradient = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point,panzer::Dim>(gradient_name, buildHarmonicVectorLayout(ir,dof_names.size()));
+  this->addEvaluatedField(gradient);
+
+  this->setName("Harmonic DOF("+value_name+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicDOF<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                      PHX::FieldManager<Traits>& fm)
+{
+  for(std::size_t i=0;i<coefficients.size();i++)
+    this->utils.setFieldData(coefficients[i],fm);
+  this->utils.setFieldData(value,fm);
+  this->utils.setFieldData(gradient,fm);
+
+  basis_index_ = panzer::getBasisIndex(basis_name_,(*sd.worksets_)[0]);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicDOF<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_harmonics = value.extent_int(1);
+  const int num_points = value.extent_int(2);
+  const int num_dims = gradient.extent_int(3);
+  const int num_basis = coefficients[0].extent_int(1);
+
+  const panzer::BasisValues2<double> & bv = *workset.bases[basis_index_];
+
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+    for (int h = 0; h < num_harmonics; ++h) {
+      const PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> & coeff = coefficients[h];
+
+      for (int point = 0; point < num_points; ++point) {
+        value(cell,h,point) = 0.0;
+        for (int d = 0; d < num_dims; ++d)
+          gradient(cell,h,point,d) = 0.0;
+      }
+
+      // each basis coefficient is read once and spread over all points
+      for (int basis = 0; basis < num_basis; ++basis) {
+        const ScalarT & c = coeff(cell,basis);
+        for (int point = 0; point < num_points; ++point) {
+          value(cell,h,point) += c*bv.basis_scalar(cell,basis,point);
+          for (int d = 0; d < num_dims; ++d)
+            gradient(cell,h,point,d) += c*bv.grad_basis(cell,basis,point,d);
+        }
+      }
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "Step01_HarmonicIndexSet.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+void buildHarmonicIndexSet(int num_frequencies,int order,
+                           TruncationScheme scheme,double alpha,
+                           std::vector<std::vector<int> > & harmonics)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(num_frequencies<1,std::logic_error,
+                             "buildHarmonicIndexSet: at least one fundamental frequency is required!");
+  TEUCHOS_TEST_FOR_EXCEPTION(scheme==TRUNCATION_ALPHA && alpha<=0.0,std::logic_error,
+                             "buildHarmonicIndexSet: the truncation alpha must be positive!");
+
+  harmonics.clear();
+
+  // walk the box [-order,order]^d like an odometer
+  std::vector<int> k(num_frequencies,-order);
+  while(true) {
+    int first_nonzero = 0;
+    for(int i=0;i<num_frequencies && first_nonzero==0;i++)
+      first_nonzero = k[i];
+
+    if(first_nonzero>0) {
+      bool keep = true;
+      if(scheme==TRUNCATION_DIAMOND) {
+        int sum = 0;
+        for(int i=0;i<num_frequencies;i++)
+          sum += std::abs(k[i]);
+        keep = (sum<=order);
+      }
+      else if(scheme==TRUNCATION_ALPHA) {
+        double sum = 0.0;
+        for(int i=0;i<num_frequencies;i++)
+          sum += std::pow(std::abs(k[i]),alpha);
+        keep = (sum<=std::pow(order,alpha)*(1.0+1.0e-12));
+      }
+
+      if(keep)
+        harmonics.push_back(k);
+    }
+
+    int i = num_frequencies-1;
+    while(i>=0 && k[i]==order)
+      k[i--] = -order;
+    if(i<0)
+      break;
+    k[i]++;
+  }
+}
+
+//**********************************************************************
+double harmonicFrequency(const std::vector<int> & harmonic,
+                         const std::vector<double> & fundamental_frequencies)
+{
+  TEUCHOS_ASSERT(harmonic.size()==fundamental_frequencies.size());
+
+  double frequency = 0.0;
+  for(std::size_t i=0;i<harmonic.size();i++)
+    frequency += harmonic[i]*fundamental_frequencies[i];
+  return frequency;
+}
+
+//**********************************************************************
+std::string harmonicSuffix(const std::vector<int> & harmonic)
+{
+  std::string suffix = "_freq";
+  for(std::size_t i=0;i<harmonic.size();i++) {
+    if(i>0)
+      suffix += "_";
+    suffix += (harmonic[i]<0 ? "m" : "") + std::to_string(std::abs(harmonic[i]));
+  }
+  return suffix;
+}
+
+}
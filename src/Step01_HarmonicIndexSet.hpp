@@ -0,0 +1,36 @@
+#ifndef __Step01_HarmonicIndexSet_hpp__
+#define __Step01_HarmonicIndexSet_hpp__
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+//! How the multi-frequency harmonic index set is truncated
+enum TruncationScheme {
+  TRUNCATION_BOX,     //!< max_i |k_i| <= H
+  TRUNCATION_DIAMOND, //!< sum_i |k_i| <= H
+  TRUNCATION_ALPHA    //!< (sum_i |k_i|^alpha)^(1/alpha) <= H
+};
+
+/** Enumerate the harmonics \f$k \in Z^d\f$ kept by a truncation of order <code>order</code>.
+  *
+  * A response with <code>d</code> fundamental frequencies \f$\omega_i\f$ is expanded in
+  * \f$\cos(k\cdot\omega t)\f$ and \f$\sin(k\cdot\omega t)\f$. Since \f$k\f$ and \f$-k\f$ give
+  * the same pair only one of them is listed (the one whose first nonzero entry is
+  * positive), and the 0th mode is left out. The ordering is lexicographic.
+  */
+void buildHarmonicIndexSet(int num_frequencies,int order,
+                           TruncationScheme scheme,double alpha,
+                           std::vector<std::vector<int> > & harmonics);
+
+//! Frequency \f$k\cdot f\f$ of a harmonic, in the units of the fundamental frequencies
+double harmonicFrequency(const std::vector<int> & harmonic,
+                         const std::vector<double> & fundamental_frequencies);
+
+//! DOF name suffix of a harmonic, e.g. "_freq2" or "_freq1_m1" for k = (1,-1)
+std::string harmonicSuffix(const std::vector<int> & harmonic);
+
+}
+
+#endif
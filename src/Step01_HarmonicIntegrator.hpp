@@ -0,0 +1,70 @@
+#ifndef __Step01_HarmonicIntegrator_hpp__
+#define __Step01_HarmonicIntegrator_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_HarmonicLayout.hpp"
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** Integrates harmonic balance terms against the basis, for all harmonics at once.
+  *
+  * For every harmonic \f$h\f$ computes
+  * \f[ R_h = \int \Big(\sum_v s_v(h)\Big)\phi + F(h)\cdot\nabla\phi \f]
+  * where the \f$s_v\f$ are (Cell,Harmonic,Point) fields and \f$F\f$ a
+  * (Cell,Harmonic,Point,Dim) flux; an optional (Cell,Point) source enters the
+  * 0th mode only. The results are written straight to one residual field per
+  * harmonic DOF, so no summation evaluators are needed.
+  *
+  * Parameters:
+  *   - "Residual Names": RCP<const std::vector<std::string> >, one per harmonic, 0th mode first
+  *   - "Value Names": RCP<const std::vector<std::string> >, the \f$s_v\f$
+  *   - "Flux Name": the \f$F\f$ ("" for none)
+  *   - "Mean Source Name": the source, a passive (double) field ("" for none)
+  *   - "Mean Source Value": the source if it is a constant, instead of "Mean Source Name"
+  *   - "Mean Source Multiplier": scales the source
+  *   - "Basis", "IR": as for the Panzer integrators
+  */
+template<typename EvalT, typename Traits>
+class HarmonicIntegrator : public PHX::EvaluatorWithBaseImpl<Traits>,
+                           public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    HarmonicIntegrator(const Teuchos::ParameterList & p);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  std::vector<PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> > residuals;
+
+  std::vector<PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point> > values;
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point,panzer::Dim> flux;
+  PHX::MDField<double,panzer::Cell,panzer::Point> source; // passive, see ClosureModelFactory
+
+  bool use_flux_;
+  bool use_source_;
+  double source_multiplier_;
+  bool constant_source_;
+  double source_value_;
+
+  std::string basis_name_;
+  std::size_t basis_index_;
+};
+
+}
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef __Step01_HarmonicIntegrator_impl_hpp__
+#define __Step01_HarmonicIntegrator_impl_hpp__
+
+#include "Teuchos_Assert.hpp"
+#include "Teuchos_ParameterList.hpp"
+
+#include "Panzer_BasisIRLayout.hpp"
+#include "Panzer_IntegrationRule.hpp"
+#include "Panzer_Workset.hpp"
+#include "Panzer_Workset_Utilities.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+HarmonicIntegrator<EvalT,Traits>::HarmonicIntegrator(const Teuchos::ParameterList & p)
+  : use_flux_(false)
+  , use_source_(false)
+  , source_multiplier_(1.0)
+  , constant_source_(false)
+  , source_value_(0.0)
+{
+  using Teuchos::RCP;
+
+  RCP<const std::vector<std::string> > residual_names = p.get<RCP<const std::vector<std::string> > >("Residual Names");
+  RCP<const std::vector<std::string> > value_names = p.get<RCP<const std::vector<std::string> > >("Value Names");
+  RCP<panzer::BasisIRLayout> basis = p.get<RCP<panzer::BasisIRLayout> >("Basis");
+  RCP<panzer::IntegrationRule> ir = p.get<RCP<panzer::IntegrationRule> >("IR");
+
+  const int num_harmonics = residual_names->size();
+  TEUCHOS_ASSERT(num_harmonics>0);
+
+  for(std::size_t i=0;i<residual_names->size();i++) {
+    residuals.push_back(PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS>((*residual_names)[i], basis->functional));
+    this->addEvaluatedField(residuals.back());
+  }
+
+  Teuchos::RCP<PHX::DataLayout> scalar_layout = buildHarmonicScalarLayout(*ir,num_harmonics);
+  for(std::size_t i=0;i<value_names->size();i++) {
+    values.push_back(PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point>((*value_names)[i], scalar_layout));
+    this->addDependentField(values.back());
+  }
+
+  const std::string flux_name = p.isParameter("Flux Name") ? p.get<std::string>("Flux Name") : "";
+  if(flux_name!="") {
+    use_flux_ = true;
+    flux = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point,panzer::Dim>(flux_name, buildHarmonicVectorLayout(*ir,num_harmonics));
+    this->addDependentField(flux);
+  }
+
+  const std::string source_name = p.isParameter("Mean Source Name") ? p.get<std::string>("Mean Source Name") : "";
+  if(source_name!="") {
+    use_source_ = true;
+    source_multiplier_ = p.isParameter("Mean Source Multiplier") ? p.get<double>("Mean Source Multiplier") : 1.0;
+    source = PHX::MDField<double,panzer::Cell,panzer::Point>(source_name, ir->dl_scalar);
+    this->addDependentField(source);
+  }
+  // a constant source is folded in as a number
+  if(p.isParameter("Mean Source Value")) {
+    TEUCHOS_TEST_FOR_EXCEPTION(use_source_,std::logic_error,
+                               "HarmonicIntegrator: give either \"Mean Source Name\" or \"Mean Source Value\"!");
+    use_source_ = true;
+    constant_source_ = true;
+    source_value_ = p.get<double>("Mean Source Value");
+    source_multiplier_ = p.isParameter("Mean Source Multiplier") ? p.get<double>("Mean Source Multiplier") : 1.0;
+  }
+
+  basis_name_ = basis->name();
+
+  this->setName("Harmonic Integrator("+(*residual_names)[0]+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicIntegrator<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                             PHX::FieldManager<Traits>& fm)
+{
+  for(std::size_t i=0;i<residuals.size();i++)
+    this->utils.setFieldData(residuals[i],fm);
+  for(std::size_t i=0;i<values.size();i++)
+    this->utils.setFieldData(values[i],fm);
+  if(use_flux_)
+    this->utils.setFieldData(flux,fm);
+  if(use_source_ && !constant_source_)
+    this->utils.setFieldData(source,fm);
+
+  basis_index_ = panzer::getBasisIndex(basis_name_,(*sd.worksets_)[0]);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicIntegrator<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_harmonics = residuals.size();
+  const int num_basis = residuals[0].extent_int(1);
+
+  const panzer::BasisValues2<double> & bv = *workset.bases[basis_index_];
+  const int num_points = bv.weighted_basis_scalar.extent_int(2);
+  const int num_dims = use_flux_ ? flux.extent_int(3) : 0;
+
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+    for (int h = 0; h < num_harmonics; ++h) {
+      PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> & residual = residuals[h];
+      const bool add_source = use_source_ && h==0;
+
+      for (int basis = 0; basis < num_basis; ++basis) {
+        residual(cell,basis) = 0.0;
+        for (int point = 0; point < num_points; ++point) {
+          const double wphi = bv.weighted_basis_scalar(cell,basis,point);
+          for (std::size_t v = 0; v < values.size(); ++v)
+            residual(cell,basis) += values[v](cell,h,point)*wphi;
+          if(add_source)
+            residual(cell,basis) += source_multiplier_*(constant_source_ ? source_value_ : source(cell,point))*wphi;
+          for (int d = 0; d < num_dims; ++d)
+            residual(cell,basis) += flux(cell,h,point,d)*bv.weighted_grad_basis(cell,basis,point,d);
+        }
+      }
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "Step01_HarmonicKroneckerOp.hpp"
+
+#include "Teuchos_Assert.hpp"
+#include "Teuchos_dyn_cast.hpp"
+
+#include "Thyra_MultiVectorStdOps.hpp"
+#include "Thyra_ProductMultiVectorBase.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+HarmonicKroneckerOp::
+HarmonicKroneckerOp(const Teuchos::RCP<const Thyra::LinearOpBase<double> > & stiffness,
+                    const Teuchos::RCP<const Thyra::LinearOpBase<double> > & mass,
+                    const Teuchos::SerialDenseMatrix<int,double> & harmonicCoupling)
+  : stiffness_(stiffness)
+  , mass_(mass)
+  , coupling_(harmonicCoupling)
+{
+  TEUCHOS_ASSERT(coupling_.numRows()==coupling_.numCols());
+  TEUCHOS_ASSERT(stiffness_->range()->isCompatible(*mass_->range()));
+
+  space_ = Thyra::productVectorSpace<double>(stiffness_->range(),coupling_.numRows());
+}
+
+//**********************************************************************
+bool HarmonicKroneckerOp::
+opSupportedImpl(Thyra::EOpTransp M_trans) const
+{
+  return Thyra::opSupported(*stiffness_,M_trans) && Thyra::opSupported(*mass_,M_trans);
+}
+
+//**********************************************************************
+void HarmonicKroneckerOp::
+applyImpl(const Thyra::EOpTransp M_trans,
+          const Thyra::MultiVectorBase<double> & X,
+          const Teuchos::Ptr<Thyra::MultiVectorBase<double> > & Y,
+          const double alpha,
+          const double beta) const
+{
+  using Teuchos::RCP;
+
+  const bool transpose = (Thyra::real_trans(M_trans)==Thyra::TRANS);
+  const int numHarmonics = coupling_.numRows();
+
+  const Thyra::ProductMultiVectorBase<double> & prodX
+      = Teuchos::dyn_cast<const Thyra::ProductMultiVectorBase<double> >(X);
+  Thyra::ProductMultiVectorBase<double> & prodY
+      = Teuchos::dyn_cast<Thyra::ProductMultiVectorBase<double> >(*Y);
+
+  // Y_i = alpha K X_i + beta Y_i: the identity part of the Kronecker product
+  for(int i=0;i<numHarmonics;i++)
+    Thyra::apply(*stiffness_,M_trans,*prodX.getMultiVectorBlock(i),
+                 prodY.getNonconstMultiVectorBlock(i).ptr(),alpha,beta);
+
+  // Y_i += alpha sum_j D_ij M X_j, with M X_j formed once per harmonic
+  RCP<Thyra::MultiVectorBase<double> > MX = Thyra::createMembers(mass_->range(),X.domain()->dim());
+  for(int j=0;j<numHarmonics;j++) {
+    bool coupled = false;
+    for(int i=0;i<numHarmonics;i++)
+      coupled |= ((transpose ? coupling_(j,i) : coupling_(i,j))!=0.0);
+    if(!coupled)
+      continue;
+
+    Thyra::apply(*mass_,M_trans,*prodX.getMultiVectorBlock(j),MX.ptr());
+
+    for(int i=0;i<numHarmonics;i++) {
+      const double d_ij = transpose ? coupling_(j,i) : coupling_(i,j);
+      if(d_ij!=0.0)
+        Thyra::update(alpha*d_ij,*MX,prodY.getNonconstMultiVectorBlock(i).ptr());
+    }
+  }
+}
+
+}
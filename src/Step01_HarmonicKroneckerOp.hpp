@@ -0,0 +1,59 @@
+#ifndef __Step01_HarmonicKroneckerOp_hpp__
+#define __Step01_HarmonicKroneckerOp_hpp__
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_SerialDenseMatrix.hpp"
+
+#include "Thyra_LinearOpDefaultBase.hpp"
+#include "Thyra_DefaultProductVectorSpace.hpp"
+
+namespace user_app {
+
+/** The harmonic balance Jacobian of a linear transient problem
+  * \f$M \dot{u} + K u = f\f$, applied implicitly as
+  * \f$J = I \otimes K + D \otimes M\f$.
+  *
+  * Here \f$D\f$ is the (small, dense) harmonic differentiation matrix and
+  * \f$K\f$, \f$M\f$ are the stiffness and mass matrices of the time domain
+  * equation set, assembled once. The operator acts on a product vector with
+  * one block per harmonic DOF, so storage is that of two mesh matrices plus
+  * \f$D\f$ rather than a CRS matrix with every harmonic coupling in it.
+  */
+class HarmonicKroneckerOp : public Thyra::LinearOpDefaultBase<double> {
+public:
+
+  HarmonicKroneckerOp(const Teuchos::RCP<const Thyra::LinearOpBase<double> > & stiffness,
+                      const Teuchos::RCP<const Thyra::LinearOpBase<double> > & mass,
+                      const Teuchos::SerialDenseMatrix<int,double> & harmonicCoupling);
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > range() const
+  { return space_; }
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > domain() const
+  { return space_; }
+
+  Teuchos::RCP<const Thyra::ProductVectorSpaceBase<double> > productSpace() const
+  { return space_; }
+
+protected:
+
+  bool opSupportedImpl(Thyra::EOpTransp M_trans) const;
+
+  void applyImpl(const Thyra::EOpTransp M_trans,
+                 const Thyra::MultiVectorBase<double> & X,
+                 const Teuchos::Ptr<Thyra::MultiVectorBase<double> > & Y,
+                 const double alpha,
+                 const double beta) const;
+
+private:
+
+  Teuchos::RCP<const Thyra::LinearOpBase<double> > stiffness_;
+  Teuchos::RCP<const Thyra::LinearOpBase<double> > mass_;
+  Teuchos::SerialDenseMatrix<int,double> coupling_;
+
+  Teuchos::RCP<const Thyra::DefaultProductVectorSpace<double> > space_;
+};
+
+}
+
+#endif
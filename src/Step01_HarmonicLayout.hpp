@@ -0,0 +1,47 @@
+#ifndef __Step01_HarmonicLayout_hpp__
+#define __Step01_HarmonicLayout_hpp__
+
+#include <string>
+
+#include "Teuchos_RCP.hpp"
+
+#include "Phalanx_ExtentTraits.hpp"
+#include "Phalanx_DataLayout_MDALayout.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_IntegrationRule.hpp"
+
+namespace user_app {
+
+/** Extent of the harmonic dimension: the 0th mode, then the cosine/sine
+  * coefficient pairs, ordered as HarmonicBalanceConfig::dofNames().
+  *
+  * Harmonic balance fields at the integration points are stored as
+  * (Cell,Harmonic,Point) (and (Cell,Harmonic,Point,Dim) for gradients), so
+  * a single evaluator visits all harmonics of a cell in one contiguous pass.
+  */
+struct Harmonic {};
+
+//! (Cell,Harmonic,Point) layout on the integration rule
+inline Teuchos::RCP<PHX::DataLayout>
+buildHarmonicScalarLayout(const panzer::IntegrationRule & ir,int num_harmonics)
+{
+  return Teuchos::rcp(new PHX::MDALayout<panzer::Cell,Harmonic,panzer::Point>(ir.workset_size,num_harmonics,ir.num_points));
+}
+
+//! (Cell,Harmonic,Point,Dim) layout on the integration rule
+inline Teuchos::RCP<PHX::DataLayout>
+buildHarmonicVectorLayout(const panzer::IntegrationRule & ir,int num_harmonics)
+{
+  return Teuchos::rcp(new PHX::MDALayout<panzer::Cell,Harmonic,panzer::Point,panzer::Dim>(ir.workset_size,num_harmonics,
+                                                                                        ir.num_points,ir.spatial_dimension));
+}
+
+}
+
+namespace PHX {
+  template<> struct is_extent<user_app::Harmonic> : std::true_type {};
+  template<> inline std::string print<user_app::Harmonic>() { return "Harmonic"; }
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include "Step01_HarmonicMeanPreconditioner.hpp"
+
+#include <map>
+#include <set>
+#include <iostream>
+
+#include "Teuchos_Assert.hpp"
+
+#include "Epetra_Comm.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Import.h"
+#include "Epetra_Map.h"
+#include "Epetra_MultiVector.h"
+
+#include "Thyra_EpetraLinearOp.hpp"
+#include "Thyra_EpetraThyraWrappers.hpp"
+
+#include "Teko_CloneFactory.hpp"
+#include "Teko_InverseFactory.hpp"
+#include "Teko_InverseLibrary.hpp"
+#include "Teko_RequestHandler.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+HarmonicMeanPreconditionerFactory::
+HarmonicMeanPreconditionerFactory()
+  : meanField_("U")
+  , meanInverse_("ML")
+{
+}
+
+//**********************************************************************
+void HarmonicMeanPreconditionerFactory::
+registerFactory()
+{
+  Teuchos::RCP<Teko::Cloneable> clone = Teuchos::rcp(new Teko::AutoClone<HarmonicMeanPreconditionerFactory>());
+  Teko::PreconditionerFactory::addPreconditionerFactory("Harmonic Mean Block Diagonal",clone);
+}
+
+//**********************************************************************
+void HarmonicMeanPreconditionerFactory::
+initializeFromParameterList(const Teuchos::ParameterList & settings)
+{
+  if(settings.isParameter("Mean Field"))
+    meanField_ = settings.get<std::string>("Mean Field");
+  if(settings.isParameter("Mean Inverse"))
+    meanInverse_ = settings.get<std::string>("Mean Inverse");
+}
+
+//**********************************************************************
+Teko::LinearOp HarmonicMeanPreconditionerFactory::
+buildPreconditionerOperator(Teko::LinearOp & lo,Teko::PreconditionerState & state) const
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  TEUCHOS_TEST_FOR_EXCEPTION(getRequestHandler()==Teuchos::null,std::logic_error,
+                             "HarmonicMeanPreconditionerFactory: no request handler to obtain the DOF manager from!");
+  RCP<const panzer::UniqueGlobalIndexer<int,int> > dofManager
+      = getRequestHandler()->request<RCP<const panzer::UniqueGlobalIndexer<int,int> > >(Teko::RequestMesg("DOF Manager"));
+
+  RCP<const Epetra_CrsMatrix> A = Teuchos::rcp_dynamic_cast<const Epetra_CrsMatrix>(Thyra::get_Epetra_Operator(*lo),true);
+  const Epetra_Map & rowMap = A->RowMap();
+
+  const int meanFieldNum = dofManager->getFieldNum(meanField_);
+  const int numFields = dofManager->getNumFields();
+
+  // pair every mean DOF with the DOF of each harmonic at the same basis function
+  std::set<int> meanGids;
+  std::vector<std::map<int,int> > meanToHarmonic(numFields);
+  {
+    std::vector<std::string> elementBlockIds;
+    dofManager->getElementBlockIds(elementBlockIds);
+
+    std::vector<int> gids;
+    for(std::size_t eb=0;eb<elementBlockIds.size();eb++) {
+      const std::string & blockId = elementBlockIds[eb];
+      const std::vector<int> & elements = dofManager->getElementBlock(blockId);
+      const std::vector<int> & meanOffsets = dofManager->getGIDFieldOffsets(blockId,meanFieldNum);
+
+      for(int field=0;field<numFields;field++) {
+        if(field==meanFieldNum)
+          continue;
+
+        const std::vector<int> & offsets = dofManager->getGIDFieldOffsets(blockId,field);
+        TEUCHOS_TEST_FOR_EXCEPTION(offsets.size()!=meanOffsets.size(),std::runtime_error,
+                                   "HarmonicMeanPreconditionerFactory: field \"" << dofManager->getFieldString(field)
+                                   << "\" does not use the basis of the mean field \"" << meanField_ << "\"!");
+      }
+
+      for(std::size_t e=0;e<elements.size();e++) {
+        dofManager->getElementGIDs(elements[e],gids,blockId);
+        for(int field=0;field<numFields;field++) {
+          const std::vector<int> & offsets = dofManager->getGIDFieldOffsets(blockId,field);
+          for(std::size_t i=0;i<offsets.size();i++)
+            meanToHarmonic[field][gids[meanOffsets[i]]] = gids[offsets[i]];
+        }
+        for(std::size_t i=0;i<meanOffsets.size();i++)
+          meanGids.insert(gids[meanOffsets[i]]);
+      }
+    }
+  }
+
+  // owned rows of each harmonic, in the order of the owned mean rows
+  std::vector<int> meanRows;
+  for(int row=0;row<rowMap.NumMyElements();row++)
+    if(meanGids.find(rowMap.GID(row))!=meanGids.end())
+      meanRows.push_back(rowMap.GID(row));
+
+  std::vector<RCP<const Epetra_Map> > blockMaps;
+  std::vector<int> harmonicRows(meanRows.size());
+  for(int field=0;field<numFields;field++) {
+    for(std::size_t r=0;r<meanRows.size();r++) {
+      harmonicRows[r] = meanToHarmonic[field][meanRows[r]];
+      // Panzer's DOF manager gives all DOFs at a node to the node's owner
+      TEUCHOS_ASSERT(rowMap.MyGID(harmonicRows[r]));
+    }
+
+    RCP<const Epetra_Map> blockMap
+        = rcp(new Epetra_Map(-1,harmonicRows.size(),harmonicRows.size()>0 ? &harmonicRows[0] : 0,0,A->Comm()));
+    if(field==meanFieldNum)
+      blockMaps.insert(blockMaps.begin(),blockMap);
+    else
+      blockMaps.push_back(blockMap);
+  }
+
+  // copy the mean diagonal block out of the Jacobian
+  RCP<Epetra_CrsMatrix> meanMatrix = rcp(new Epetra_CrsMatrix(Copy,*blockMaps[0],0));
+  {
+    std::vector<double> values(A->MaxNumEntries());
+    std::vector<int> indices(A->MaxNumEntries());
+    std::vector<double> meanValues(A->MaxNumEntries());
+    std::vector<int> meanIndices(A->MaxNumEntries());
+    for(std::size_t r=0;r<meanRows.size();r++) {
+      int numEntries = 0;
+      A->ExtractGlobalRowCopy(meanRows[r],values.size(),numEntries,&values[0],&indices[0]);
+
+      int numMeanEntries = 0;
+      for(int j=0;j<numEntries;j++) {
+        if(meanGids.find(indices[j])==meanGids.end())
+          continue;
+
+        meanValues[numMeanEntries] = values[j];
+        meanIndices[numMeanEntries] = indices[j];
+        numMeanEntries++;
+      }
+
+      meanMatrix->InsertGlobalValues(meanRows[r],numMeanEntries,&meanValues[0],&meanIndices[0]);
+    }
+    meanMatrix->FillComplete();
+  }
+
+  RCP<Teko::InverseFactory> inverseFactory = getInverseLibrary()->getInverseFactory(meanInverse_);
+  Teko::LinearOp meanInverse = Teko::buildInverse(*inverseFactory,Thyra::epetraLinearOp(meanMatrix));
+
+  if(A->Comm().MyPID()==0)
+    std::cout << "Harmonic mean preconditioner: one \"" << meanInverse_ << "\" inverse of \"" << meanField_
+              << "\" applied to " << blockMaps.size() << " harmonic block(s)" << std::endl;
+
+  return rcp(new HarmonicMeanBlockDiagonalOp(meanInverse,Teuchos::rcpFromRef(rowMap),blockMaps));
+}
+
+//**********************************************************************
+HarmonicMeanBlockDiagonalOp::
+HarmonicMeanBlockDiagonalOp(const Teuchos::RCP<const Thyra::LinearOpBase<double> > & meanInverse,
+                            const Teuchos::RCP<const Epetra_Map> & rowMap,
+                            const std::vector<Teuchos::RCP<const Epetra_Map> > & blockMaps)
+  : meanInverse_(meanInverse)
+  , rowMap_(Teuchos::rcp(new Epetra_Map(*rowMap)))
+  , blockMaps_(blockMaps)
+{
+  for(std::size_t b=0;b<blockMaps_.size();b++)
+    importers_.push_back(Teuchos::rcp(new Epetra_Import(*blockMaps_[b],*rowMap_)));
+
+  space_ = Thyra::create_VectorSpace(rowMap_);
+}
+
+//**********************************************************************
+void HarmonicMeanBlockDiagonalOp::
+applyImpl(const Thyra::EOpTransp M_trans,
+          const Thyra::MultiVectorBase<double> & X,
+          const Teuchos::Ptr<Thyra::MultiVectorBase<double> > & Y,
+          const double alpha,
+          const double beta) const
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  TEUCHOS_ASSERT(M_trans==Thyra::NOTRANS);
+
+  RCP<const Epetra_MultiVector> epetraX = Thyra::get_Epetra_MultiVector(*rowMap_,X);
+  RCP<Epetra_MultiVector> epetraY = Thyra::get_Epetra_MultiVector(*rowMap_,Teuchos::rcpFromPtr(Y));
+  const int numVecs = epetraX->NumVectors();
+
+  Epetra_MultiVector Z(*rowMap_,numVecs);
+  for(std::size_t b=0;b<blockMaps_.size();b++) {
+    Epetra_MultiVector xb(*blockMaps_[b],numVecs);
+    Epetra_MultiVector yb(*blockMaps_[b],numVecs);
+    xb.Import(*epetraX,*importers_[b],Insert);
+
+    // the harmonic rows are in the local order of the mean rows, so view them on the mean map
+    RCP<Epetra_MultiVector> xMean = rcp(new Epetra_MultiVector(View,*blockMaps_[0],xb.Values(),xb.Stride(),numVecs));
+    RCP<Epetra_MultiVector> yMean = rcp(new Epetra_MultiVector(View,*blockMaps_[0],yb.Values(),yb.Stride(),numVecs));
+
+    RCP<const Thyra::MultiVectorBase<double> > th_x = Thyra::create_MultiVector(xMean.getConst(),meanInverse_->domain());
+    RCP<Thyra::MultiVectorBase<double> > th_y = Thyra::create_MultiVector(yMean,meanInverse_->range());
+    Thyra::apply(*meanInverse_,Thyra::NOTRANS,*th_x,th_y.ptr());
+
+    Z.Export(yb,*importers_[b],Insert);
+  }
+
+  epetraY->Update(alpha,Z,beta);
+}
+
+}
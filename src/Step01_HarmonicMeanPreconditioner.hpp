@@ -0,0 +1,134 @@
+#ifndef __Step01_HarmonicMeanPreconditioner_hpp__
+#define __Step01_HarmonicMeanPreconditioner_hpp__
+
+#include <string>
+#include <vector>
+
+#include "Teuchos_RCP.hpp"
+
+#include "Thyra_LinearOpDefaultBase.hpp"
+
+#include "Teko_PreconditionerFactory.hpp"
+#include "Teko_RequestCallback.hpp"
+
+#include "Panzer_UniqueGlobalIndexer.hpp"
+
+class Epetra_Import;
+class Epetra_Map;
+
+namespace user_app {
+
+/** Hands the DOF manager to preconditioners that ask for "DOF Manager"
+  * through the Teko request handler given to <code>panzer_stk::buildLOWSFactory</code>.
+  */
+class DOFManagerRequestCallback
+  : public Teko::RequestCallback<Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > > {
+public:
+
+  DOFManagerRequestCallback(const Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > & dofManager)
+    : dofManager_(dofManager) {}
+
+  bool handlesRequest(const Teko::RequestMesg & rm)
+  { return rm.getName()=="DOF Manager"; }
+
+  Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > request(const Teko::RequestMesg & rm)
+  { return dofManager_; }
+
+  void preRequest(const Teko::RequestMesg & rm) {}
+
+private:
+
+  Teuchos::RCP<const panzer::UniqueGlobalIndexer<int,int> > dofManager_;
+};
+
+/** Block diagonal preconditioner for harmonic balance systems.
+  *
+  * Every harmonic of a harmonic balance system has (up to the small frequency
+  * coupling) the operator of the 0th mode on its diagonal block. This factory
+  * copies the mean field's diagonal block out of the assembled Jacobian, builds
+  * one inverse for it (any Teko inverse: ML, MueLu, Ifpack, Amesos, ...) and
+  * applies that single inverse to each harmonic in turn. It is selected through
+  * Teko in the "Linear Solver" list, e.g.
+  *
+  * \verbatim
+    <Parameter name="Preconditioner Type" type="string" value="Teko"/>
+    <ParameterList name="Preconditioner Types">
+      <ParameterList name="Teko">
+        <Parameter name="Inverse Type" type="string" value="HB Mean"/>
+        <ParameterList name="Inverse Factory Library">
+          <ParameterList name="HB Mean">
+            <Parameter name="Type" type="string" value="Harmonic Mean Block Diagonal"/>
+            <Parameter name="Mean Field" type="string" value="U"/>
+            <Parameter name="Mean Inverse" type="string" value="ML"/>
+          </ParameterList>
+        </ParameterList>
+      </ParameterList>
+    </ParameterList>
+    \endverbatim
+  *
+  * The DOF manager is obtained with a "DOF Manager" request (see DOFManagerRequestCallback).
+  * Every field other than the mean field is treated as a harmonic and must use the mean field's basis.
+  */
+class HarmonicMeanPreconditionerFactory : public Teko::PreconditionerFactory {
+public:
+
+  HarmonicMeanPreconditionerFactory();
+
+  Teko::LinearOp buildPreconditionerOperator(Teko::LinearOp & lo,Teko::PreconditionerState & state) const;
+
+  //! Add this factory to Teko under the type name "Harmonic Mean Block Diagonal"
+  static void registerFactory();
+
+protected:
+
+  void initializeFromParameterList(const Teuchos::ParameterList & settings);
+
+private:
+
+  std::string meanField_;
+  std::string meanInverse_;
+};
+
+/** Applies one inverse of the mean operator to every harmonic block.
+  */
+class HarmonicMeanBlockDiagonalOp : public Thyra::LinearOpDefaultBase<double> {
+public:
+
+  /** \param[in] meanInverse Inverse of the mean block, on <code>blockMaps[0]</code>
+    * \param[in] rowMap Row map of the full harmonic balance system
+    * \param[in] blockMaps Owned rows of each harmonic, all in the local order of the mean rows
+    */
+  HarmonicMeanBlockDiagonalOp(const Teuchos::RCP<const Thyra::LinearOpBase<double> > & meanInverse,
+                              const Teuchos::RCP<const Epetra_Map> & rowMap,
+                              const std::vector<Teuchos::RCP<const Epetra_Map> > & blockMaps);
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > range() const
+  { return space_; }
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > domain() const
+  { return space_; }
+
+protected:
+
+  bool opSupportedImpl(Thyra::EOpTransp M_trans) const
+  { return M_trans==Thyra::NOTRANS; }
+
+  void applyImpl(const Thyra::EOpTransp M_trans,
+                 const Thyra::MultiVectorBase<double> & X,
+                 const Teuchos::Ptr<Thyra::MultiVectorBase<double> > & Y,
+                 const double alpha,
+                 const double beta) const;
+
+private:
+
+  Teuchos::RCP<const Thyra::LinearOpBase<double> > meanInverse_;
+  Teuchos::RCP<const Epetra_Map> rowMap_;
+  std::vector<Teuchos::RCP<const Epetra_Map> > blockMaps_;
+  std::vector<Teuchos::RCP<Epetra_Import> > importers_;
+
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > space_;
+};
+
+}
+
+#endif
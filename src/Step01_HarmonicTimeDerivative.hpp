@@ -0,0 +1,58 @@
+#ifndef __Step01_HarmonicTimeDerivative_hpp__
+#define __Step01_HarmonicTimeDerivative_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_HarmonicLayout.hpp"
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** Time derivative of a harmonic balance field, in the harmonic dimension.
+  *
+  * Substituting \f$u = a_k \cos(\omega_k t) + b_k \sin(\omega_k t)\f$ into \f$u_t\f$
+  * gives \f$\omega_k b_k \cos(\omega_k t) - \omega_k a_k \sin(\omega_k t)\f$, so the
+  * derivative of the (Cell,Harmonic,Point) field is zero in the 0th mode and
+  * swaps (with a sign) the cosine and sine coefficients of every harmonic.
+  */
+template<typename EvalT, typename Traits>
+class HarmonicTimeDerivative : public PHX::EvaluatorWithBaseImpl<Traits>,
+                               public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    /** \param[in] value_name The (Cell,Harmonic,Point) field
+      * \param[in] dxdt_name Name of its time derivative, same layout
+      * \param[in] frequencies Frequency (cycles per unit time) of each harmonic DOF,
+      *            the 0th mode excluded (see HarmonicBalanceConfig::harmonicDOFFrequencies)
+      */
+    HarmonicTimeDerivative(const std::string & value_name,
+                           const std::string & dxdt_name,
+                           const std::vector<double> & frequencies,
+                           const panzer::IntegrationRule & ir);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point> value;
+  PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point> dxdt;
+
+  // angular frequency of each cosine/sine pair
+  std::vector<double> omega_;
+};
+
+}
+
+#endif
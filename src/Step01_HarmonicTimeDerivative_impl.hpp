@@ -0,0 +1,67 @@
+#ifndef __Step01_HarmonicTimeDerivative_impl_hpp__
+#define __Step01_HarmonicTimeDerivative_impl_hpp__
+
+#include <cmath>
+
+#include "Teuchos_Assert.hpp"
+
+#include "Panzer_IntegrationRule.hpp"
+#include "Panzer_Workset.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+HarmonicTimeDerivative<EvalT,Traits>::HarmonicTimeDerivative(const std::string & value_name,
+                                                             const std::string & dxdt_name,
+                                                             const std::vector<double> & frequencies,
+                                                             const panzer::IntegrationRule & ir)
+{
+  TEUCHOS_ASSERT(frequencies.size()%2==0);
+  for(std::size_t i=0;i<frequencies.size();i+=2)
+    omega_.push_back(2.0*M_PI*frequencies[i]);
+
+  Teuchos::RCP<PHX::DataLayout> data_layout = buildHarmonicScalarLayout(ir,frequencies.size()+1);
+
+  value = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point>(value_name, data_layout);
+  this->addDependentField(value);
+
+  dxdt = PHX::MDField<ScalarT,panzer::Cell,Harmonic,panzer::Point>(dxdt_name, data_layout);
+  this->addEvaluatedField(dxdt);
+
+  this->setName("Harmonic Time Derivative("+dxdt_name+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicTimeDerivative<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                                 PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(value,fm);
+  this->utils.setFieldData(dxdt,fm);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void HarmonicTimeDerivative<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_points = value.extent_int(2);
+
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+    for (int point = 0; point < num_points; ++point)
+      dxdt(cell,0,point) = 0.0;
+
+    for (std::size_t k = 0; k < omega_.size(); ++k) {
+      const int c = 2*static_cast<int>(k)+1, s = c+1;
+      for (int point = 0; point < num_points; ++point) {
+        dxdt(cell,c,point) =  omega_[k]*value(cell,s,point);
+        dxdt(cell,s,point) = -omega_[k]*value(cell,c,point);
+      }
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
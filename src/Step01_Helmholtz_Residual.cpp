@@ -0,0 +1,6 @@
+#include "Panzer_ExplicitTemplateInstantiation.hpp"
+
+#include "Step01_Helmholtz_Residual.hpp"
+#include "Step01_Helmholtz_Residual_impl.hpp"
+
+PANZER_INSTANTIATE_TEMPLATE_CLASS_TWO_T(user_app::Helmholtz_Residual)
@@ -0,0 +1,68 @@
+#ifndef __Step01_Helmholtz_Residual_hpp__
+#define __Step01_Helmholtz_Residual_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** The complete Helmholtz residual in a single pass over the integration points,
+  * \f[ R = (u,\phi) - (f,\phi) + (\nabla u,\nabla\phi) \f]
+  * plus \f$(u_t,\phi)\f$ for transient problems and \f$(c u^3,\phi)\f$ for the
+  * nonlinear reaction term. The scalar terms are summed at each point first, so
+  * there are no per-term residual fields and no summation evaluator.
+  *
+  * Parameters:
+  *   - "Residual Name": the (Cell,BASIS) residual
+  *   - "DOF Name": \f$u\f$ at the integration points, its gradient is "GRAD_" + "DOF Name"
+  *   - "Source Name": \f$f\f$, a passive (double) field
+  *   - "Source Value": \f$f\f$ if it is a constant, instead of "Source Name"
+  *   - "Time Derivative Name": \f$u_t\f$ ("" for a steady problem)
+  *   - "Nonlinear Coefficient": \f$c\f$ (0 for none)
+  *   - "Basis", "IR": as for the Panzer integrators
+  */
+template<typename EvalT, typename Traits>
+class Helmholtz_Residual : public PHX::EvaluatorWithBaseImpl<Traits>,
+                           public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    Helmholtz_Residual(const Teuchos::ParameterList & p);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> residual;
+
+  PHX::MDField<ScalarT,panzer::Cell,panzer::Point> dof;
+  PHX::MDField<ScalarT,panzer::Cell,panzer::Point,panzer::Dim> dof_gradient;
+  PHX::MDField<double,panzer::Cell,panzer::Point> source; // passive, see ClosureModelFactory
+  PHX::MDField<ScalarT,panzer::Cell,panzer::Point> dof_time_derivative;
+
+  bool transient_;
+  double nonlinear_coefficient_;
+  bool constant_source_;
+  double source_value_;
+
+  std::string basis_name_;
+  std::size_t basis_index_;
+
+  // sum of the scalar terms at each point of a cell
+  std::vector<ScalarT> point_values_;
+};
+
+}
+
+#endif
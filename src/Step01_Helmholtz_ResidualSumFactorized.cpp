@@ -0,0 +1,6 @@
+#include "Panzer_ExplicitTemplateInstantiation.hpp"
+
+#include "Step01_Helmholtz_ResidualSumFactorized.hpp"
+#include "Step01_Helmholtz_ResidualSumFactorized_impl.hpp"
+
+PANZER_INSTANTIATE_TEMPLATE_CLASS_TWO_T(user_app::Helmholtz_ResidualSumFactorized)
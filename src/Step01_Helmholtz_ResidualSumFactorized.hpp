@@ -0,0 +1,73 @@
+#ifndef __Step01_Helmholtz_ResidualSumFactorized_hpp__
+#define __Step01_Helmholtz_ResidualSumFactorized_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_TensorProductQuadBasis.hpp"
+
+#include <string>
+#include <vector>
+
+namespace user_app {
+
+/** The Helmholtz residual of Helmholtz_Residual, assembled by sum factorization
+  * on tensor-product quadrilaterals.
+  *
+  * Works on the gathered basis coefficients rather than on the DOF values at the
+  * integration points: values and gradients are interpolated, and the residual
+  * integrated, one direction at a time with the 1D factors of the basis (see
+  * TensorProductQuadBasis). Geometry enters pointwise through the inverse
+  * Jacobian and the weighted measure, so the cells need not be affine. If the
+  * basis or the cubature turn out not to factor, the evaluator falls back to the
+  * full basis by point contractions. The 1D factors are unoriented, so the
+  * basis must not require orientations (HGrad up to order 2).
+  *
+  * Parameters are those of Helmholtz_Residual; "DOF Name" and "Time Derivative
+  * Name" name the gathered (Cell,BASIS) coefficients.
+  */
+template<typename EvalT, typename Traits>
+class Helmholtz_ResidualSumFactorized : public PHX::EvaluatorWithBaseImpl<Traits>,
+                                        public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    Helmholtz_ResidualSumFactorized(const Teuchos::ParameterList & p);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+  typedef typename EvalT::ScalarT ScalarT;
+
+  PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> residual;
+
+  PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> dof_coefficients;
+  PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS> dof_time_derivative_coefficients;
+  PHX::MDField<double,panzer::Cell,panzer::Point> source; // passive, see ClosureModelFactory
+
+  bool transient_;
+  double nonlinear_coefficient_;
+  bool constant_source_;
+  double source_value_;
+
+  std::string basis_name_;
+  std::size_t basis_index_;
+  int ir_degree_;
+  int ir_index_;
+
+  Teuchos::RCP<const TensorProductQuadBasis> tensor_basis_;
+
+  // per point values of a cell, and kernel scratch
+  std::vector<ScalarT> u_, u_t_, u_xi_, u_eta_, s_, flux_xi_, flux_eta_, scratch_;
+};
+
+}
+
+#endif
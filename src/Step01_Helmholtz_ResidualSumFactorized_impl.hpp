@@ -0,0 +1,183 @@
+#ifndef __Step01_Helmholtz_ResidualSumFactorized_impl_hpp__
+#define __Step01_Helmholtz_ResidualSumFactorized_impl_hpp__
+
+#include <iostream>
+
+#include "Teuchos_ParameterList.hpp"
+
+#include "Panzer_BasisIRLayout.hpp"
+#include "Panzer_IntegrationRule.hpp"
+#include "Panzer_Workset.hpp"
+#include "Panzer_Workset_Utilities.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+Helmholtz_ResidualSumFactorized<EvalT,Traits>::Helmholtz_ResidualSumFactorized(const Teuchos::ParameterList & p)
+  : transient_(false)
+  , nonlinear_coefficient_(0.0)
+  , constant_source_(false)
+  , source_value_(0.0)
+{
+  using Teuchos::RCP;
+
+  RCP<panzer::BasisIRLayout> basis = p.get<RCP<panzer::BasisIRLayout> >("Basis");
+  RCP<panzer::IntegrationRule> ir = p.get<RCP<panzer::IntegrationRule> >("IR");
+
+  residual = PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS>(p.get<std::string>("Residual Name"), basis->functional);
+  this->addEvaluatedField(residual);
+
+  dof_coefficients = PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS>(p.get<std::string>("DOF Name"), basis->functional);
+  this->addDependentField(dof_coefficients);
+
+  // a constant source is folded in as a number
+  constant_source_ = p.isParameter("Source Value");
+  if(constant_source_)
+    source_value_ = p.get<double>("Source Value");
+  else {
+    source = PHX::MDField<double,panzer::Cell,panzer::Point>(p.get<std::string>("Source Name"), ir->dl_scalar);
+    this->addDependentField(source);
+  }
+
+  const std::string time_derivative_name = p.isParameter("Time Derivative Name") ? p.get<std::string>("Time Derivative Name") : "";
+  if(time_derivative_name!="") {
+    transient_ = true;
+    dof_time_derivative_coefficients = PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS>(time_derivative_name, basis->functional);
+    this->addDependentField(dof_time_derivative_coefficients);
+  }
+
+  if(p.isParameter("Nonlinear Coefficient"))
+    nonlinear_coefficient_ = p.get<double>("Nonlinear Coefficient");
+
+  basis_name_ = basis->name();
+  ir_degree_ = ir->cubature_degree;
+
+  this->setName("Helmholtz Residual Sum Factorized("+residual.fieldTag().name()+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void Helmholtz_ResidualSumFactorized<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                                          PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(residual,fm);
+  this->utils.setFieldData(dof_coefficients,fm);
+  if(!constant_source_)
+    this->utils.setFieldData(source,fm);
+  if(transient_)
+    this->utils.setFieldData(dof_time_derivative_coefficients,fm);
+
+  const panzer::Workset & workset = (*sd.worksets_)[0];
+  basis_index_ = panzer::getBasisIndex(basis_name_,workset);
+  ir_index_ = panzer::getIntegrationRuleIndex(ir_degree_,workset);
+
+  // factor the basis from its reference values, which are the same for every cell
+  const panzer::BasisValues2<double> & bv = *workset.bases[basis_index_];
+  const panzer::IntegrationValues2<double> & iv = *workset.int_rules[ir_index_];
+  const int num_basis = residual.extent_int(1);
+  const int num_points = iv.weighted_measure.extent_int(1);
+
+  std::vector<double> ref_points(2*num_points), ref_values(num_basis*num_points), ref_grads(2*num_basis*num_points);
+  for(int q=0;q<num_points;q++)
+    for(int d=0;d<2;d++)
+      ref_points[2*q+d] = iv.cub_points(q,d);
+  for(int b=0;b<num_basis;b++) {
+    for(int q=0;q<num_points;q++) {
+      ref_values[b*num_points+q] = bv.basis_ref_scalar(b,q);
+      for(int d=0;d<2;d++)
+        ref_grads[2*(b*num_points+q)+d] = bv.grad_basis_ref(b,q,d);
+    }
+  }
+
+  tensor_basis_ = Teuchos::rcp(new TensorProductQuadBasis(num_basis,num_points,ref_points,ref_values,ref_grads));
+  if(!tensor_basis_->isTensorProduct())
+    std::cout << "Warning: \"" << basis_name_ << "\" does not factor on the cubature, "
+              << this->getName() << " uses the full basis." << std::endl;
+
+  u_.resize(num_points);
+  u_t_.resize(num_points);
+  u_xi_.resize(num_points);
+  u_eta_.resize(num_points);
+  s_.resize(num_points);
+  flux_xi_.resize(num_points);
+  flux_eta_.resize(num_points);
+  scratch_.resize(tensor_basis_->scratchSize());
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void Helmholtz_ResidualSumFactorized<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_basis = residual.extent_int(1);
+
+  const panzer::BasisValues2<double> & bv = *workset.bases[basis_index_];
+  const panzer::IntegrationValues2<double> & iv = *workset.int_rules[ir_index_];
+  const int num_points = iv.weighted_measure.extent_int(1);
+  const bool factored = tensor_basis_->isTensorProduct();
+
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+
+    // u, u_t and the reference gradient of u at the points
+    if(factored) {
+      tensor_basis_->interpolate([&](int b) { return ScalarT(dof_coefficients(cell,b)); },
+                                 &u_[0],&u_xi_[0],&u_eta_[0],scratch_);
+      if(transient_)
+        tensor_basis_->interpolate([&](int b) { return ScalarT(dof_time_derivative_coefficients(cell,b)); },
+                                   &u_t_[0],(ScalarT*)0,(ScalarT*)0,scratch_);
+    }
+    else {
+      for (int point = 0; point < num_points; ++point) {
+        u_[point] = 0.0; u_t_[point] = 0.0; u_xi_[point] = 0.0; u_eta_[point] = 0.0;
+        for (int basis = 0; basis < num_basis; ++basis) {
+          u_[point]     += dof_coefficients(cell,basis)*bv.basis_ref_scalar(basis,point);
+          u_xi_[point]  += dof_coefficients(cell,basis)*bv.grad_basis_ref(basis,point,0);
+          u_eta_[point] += dof_coefficients(cell,basis)*bv.grad_basis_ref(basis,point,1);
+          if(transient_)
+            u_t_[point] += dof_time_derivative_coefficients(cell,basis)*bv.basis_ref_scalar(basis,point);
+        }
+      }
+    }
+
+    // pointwise physics: s = (u - f + u_t + c u^3) w|J|, flux = J^{-1} J^{-T} grad_ref u w|J|
+    for (int point = 0; point < num_points; ++point) {
+      const double wm = iv.weighted_measure(cell,point);
+
+      s_[point] = u_[point] - (constant_source_ ? source_value_ : source(cell,point));
+      if(transient_)
+        s_[point] += u_t_[point];
+      if(nonlinear_coefficient_!=0.0)
+        s_[point] += nonlinear_coefficient_*u_[point]*u_[point]*u_[point];
+      s_[point] *= wm;
+
+      flux_xi_[point] = 0.0;
+      flux_eta_[point] = 0.0;
+      for (int k = 0; k < 2; ++k) {
+        const ScalarT grad_k = u_xi_[point]*iv.jac_inv(cell,point,0,k) + u_eta_[point]*iv.jac_inv(cell,point,1,k);
+        flux_xi_[point]  += wm*iv.jac_inv(cell,point,0,k)*grad_k;
+        flux_eta_[point] += wm*iv.jac_inv(cell,point,1,k)*grad_k;
+      }
+    }
+
+    // integrate against the basis
+    if(factored) {
+      tensor_basis_->integrate(&s_[0],&flux_xi_[0],&flux_eta_[0],
+                               [&](int b,const ScalarT & value) { residual(cell,b) = value; },
+                               scratch_);
+    }
+    else {
+      for (int basis = 0; basis < num_basis; ++basis) {
+        residual(cell,basis) = 0.0;
+        for (int point = 0; point < num_points; ++point)
+          residual(cell,basis) += s_[point]*bv.basis_ref_scalar(basis,point)
+                                + flux_xi_[point]*bv.grad_basis_ref(basis,point,0)
+                                + flux_eta_[point]*bv.grad_basis_ref(basis,point,1);
+      }
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
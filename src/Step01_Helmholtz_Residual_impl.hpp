@@ -0,0 +1,112 @@
+#ifndef __Step01_Helmholtz_Residual_impl_hpp__
+#define __Step01_Helmholtz_Residual_impl_hpp__
+
+#include "Teuchos_ParameterList.hpp"
+
+#include "Panzer_BasisIRLayout.hpp"
+#include "Panzer_IntegrationRule.hpp"
+#include "Panzer_Workset.hpp"
+#include "Panzer_Workset_Utilities.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+Helmholtz_Residual<EvalT,Traits>::Helmholtz_Residual(const Teuchos::ParameterList & p)
+  : transient_(false)
+  , nonlinear_coefficient_(0.0)
+  , constant_source_(false)
+  , source_value_(0.0)
+{
+  using Teuchos::RCP;
+
+  const std::string dof_name = p.get<std::string>("DOF Name");
+  RCP<panzer::BasisIRLayout> basis = p.get<RCP<panzer::BasisIRLayout> >("Basis");
+  RCP<panzer::IntegrationRule> ir = p.get<RCP<panzer::IntegrationRule> >("IR");
+
+  residual = PHX::MDField<ScalarT,panzer::Cell,panzer::BASIS>(p.get<std::string>("Residual Name"), basis->functional);
+  this->addEvaluatedField(residual);
+
+  dof = PHX::MDField<ScalarT,panzer::Cell,panzer::Point>(dof_name, ir->dl_scalar);
+  this->addDependentField(dof);
+
+  dof_gradient = PHX::MDField<ScalarT,panzer::Cell,panzer::Point,panzer::Dim>("GRAD_"+dof_name, ir->dl_vector);
+  this->addDependentField(dof_gradient);
+
+  // a constant source is folded in as a number
+  constant_source_ = p.isParameter("Source Value");
+  if(constant_source_)
+    source_value_ = p.get<double>("Source Value");
+  else {
+    source = PHX::MDField<double,panzer::Cell,panzer::Point>(p.get<std::string>("Source Name"), ir->dl_scalar);
+    this->addDependentField(source);
+  }
+
+  const std::string time_derivative_name = p.isParameter("Time Derivative Name") ? p.get<std::string>("Time Derivative Name") : "";
+  if(time_derivative_name!="") {
+    transient_ = true;
+    dof_time_derivative = PHX::MDField<ScalarT,panzer::Cell,panzer::Point>(time_derivative_name, ir->dl_scalar);
+    this->addDependentField(dof_time_derivative);
+  }
+
+  if(p.isParameter("Nonlinear Coefficient"))
+    nonlinear_coefficient_ = p.get<double>("Nonlinear Coefficient");
+
+  basis_name_ = basis->name();
+
+  this->setName("Helmholtz Residual("+residual.fieldTag().name()+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void Helmholtz_Residual<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                             PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(residual,fm);
+  this->utils.setFieldData(dof,fm);
+  this->utils.setFieldData(dof_gradient,fm);
+  if(!constant_source_)
+    this->utils.setFieldData(source,fm);
+  if(transient_)
+    this->utils.setFieldData(dof_time_derivative,fm);
+
+  basis_index_ = panzer::getBasisIndex(basis_name_,(*sd.worksets_)[0]);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void Helmholtz_Residual<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_basis = residual.extent_int(1);
+  const int num_points = dof.extent_int(1);
+  const int num_dims = dof_gradient.extent_int(2);
+
+  const panzer::BasisValues2<double> & bv = *workset.bases[basis_index_];
+
+  point_values_.resize(num_points);
+
+  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
+    // u - f (+ u_t + c u^3), once per point
+    for (int point = 0; point < num_points; ++point) {
+      point_values_[point] = dof(cell,point) - (constant_source_ ? source_value_ : source(cell,point));
+      if(transient_)
+        point_values_[point] += dof_time_derivative(cell,point);
+      if(nonlinear_coefficient_!=0.0)
+        point_values_[point] += nonlinear_coefficient_*dof(cell,point)*dof(cell,point)*dof(cell,point);
+    }
+
+    for (int basis = 0; basis < num_basis; ++basis) {
+      residual(cell,basis) = 0.0;
+      for (int point = 0; point < num_points; ++point) {
+        residual(cell,basis) += point_values_[point]*bv.weighted_basis_scalar(cell,basis,point);
+        for (int d = 0; d < num_dims; ++d)
+          residual(cell,basis) += dof_gradient(cell,point,d)*bv.weighted_grad_basis(cell,basis,point,d);
+      }
+    }
+  }
+}
+
+//**********************************************************************
+}
+
+#endif
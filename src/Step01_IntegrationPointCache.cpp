@@ -0,0 +1,54 @@
+#include "Step01_IntegrationPointCache.hpp"
+
+#include "Panzer_IntegrationValues2.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+IntegrationPointCache::Fingerprint IntegrationPointCache::
+fingerprint(const panzer::Workset & workset,int ir_index)
+{
+  const panzer::IntegrationValues2<double> & iv = *workset.int_rules[ir_index];
+
+  Fingerprint fp;
+  fp.num_cells = workset.num_cells;
+  if(workset.num_cells>0) {
+    const int num_points = iv.ip_coordinates.extent_int(1);
+    const int dim = iv.ip_coordinates.extent_int(2);
+    for(int d=0;d<dim;d++)
+      fp.coordinates.push_back(iv.ip_coordinates(0,0,d));
+    for(int d=0;d<dim;d++)
+      fp.coordinates.push_back(iv.ip_coordinates(workset.num_cells-1,num_points-1,d));
+  }
+  return fp;
+}
+
+//**********************************************************************
+const double * IntegrationPointCache::
+find(const panzer::Workset & workset,int ir_index)
+{
+  std::map<std::pair<std::size_t,int>,Entry>::iterator itr
+      = entries_.find(std::make_pair(workset.getIdentifier(),ir_index));
+  if(itr==entries_.end())
+    return 0;
+
+  // stale, the workset was rebuilt on a different mesh
+  if(!(itr->second.fingerprint==fingerprint(workset,ir_index))) {
+    entries_.erase(itr);
+    return 0;
+  }
+
+  return itr->second.values.empty() ? 0 : &itr->second.values[0];
+}
+
+//**********************************************************************
+double * IntegrationPointCache::
+insert(const panzer::Workset & workset,int ir_index,int num_points)
+{
+  Entry & entry = entries_[std::make_pair(workset.getIdentifier(),ir_index)];
+  entry.fingerprint = fingerprint(workset,ir_index);
+  entry.values.assign(workset.num_cells*num_points,0.0);
+  return entry.values.empty() ? 0 : &entry.values[0];
+}
+
+}
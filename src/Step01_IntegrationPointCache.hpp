@@ -0,0 +1,67 @@
+#ifndef __Step01_IntegrationPointCache_hpp__
+#define __Step01_IntegrationPointCache_hpp__
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Panzer_Workset.hpp"
+
+namespace user_app {
+
+/** Integration point values of a closure model that depend on the geometry only.
+  *
+  * The values of a workset are stored under its identifier and the index of the
+  * integration rule, in (Cell,Point) order. With every entry the number of cells
+  * and the coordinates of the first and last integration points are kept; an
+  * entry whose workset no longer matches them (the mesh changed) is dropped, so
+  * a lookup only costs a map search and a handful of comparisons. The parameters
+  * of the model are fixed at construction, a model that changes them must call
+  * clear().
+  */
+class IntegrationPointCache {
+public:
+
+  /** Values of a workset, or null if they are not stored for the current geometry
+    * of the workset.
+    */
+  const double * find(const panzer::Workset & workset,int ir_index);
+
+  /** Storage for the values of a workset, to be filled by the caller, replacing
+    * whatever was stored for it.
+    */
+  double * insert(const panzer::Workset & workset,int ir_index,int num_points);
+
+  //! Drop all the stored values
+  void clear()
+  { entries_.clear(); }
+
+  //! Number of worksets with stored values
+  std::size_t size() const
+  { return entries_.size(); }
+
+private:
+
+  // enough of the geometry to notice that a workset was rebuilt
+  struct Fingerprint {
+    panzer::index_t num_cells;
+    std::vector<double> coordinates;
+
+    bool operator==(const Fingerprint & other) const
+    { return num_cells==other.num_cells && coordinates==other.coordinates; }
+  };
+
+  struct Entry {
+    Fingerprint fingerprint;
+    std::vector<double> values;
+  };
+
+  static Fingerprint fingerprint(const panzer::Workset & workset,int ir_index);
+
+  std::map<std::pair<std::size_t,int>,Entry> entries_;
+};
+
+}
+
+#endif
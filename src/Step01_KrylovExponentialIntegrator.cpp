@@ -0,0 +1,320 @@
+#include "Step01_KrylovExponentialIntegrator.hpp"
+
+#include <cmath>
+
+#include "Teuchos_Assert.hpp"
+#include "Teuchos_LAPACK.hpp"
+
+#include "Thyra_EpetraThyraWrappers.hpp"
+#include "Thyra_EpetraLinearOp.hpp"
+#include "Thyra_LinearOpWithSolveFactoryHelpers.hpp"
+#include "Thyra_VectorStdOps.hpp"
+
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Map.h"
+#include "Epetra_Vector.h"
+
+namespace user_app {
+
+namespace {
+
+typedef Teuchos::SerialDenseMatrix<int,double> DenseMatrix;
+
+// X <- exp(X), by scaling and squaring of the (6,6) Pade approximant
+void exponential(DenseMatrix & X)
+{
+  const int n = X.numRows();
+
+  int squarings = 0;
+  const double norm = X.normOne();
+  if(norm>0.5)
+    squarings = int(std::ceil(std::log(norm/0.5)/std::log(2.0)));
+  X.scale(std::pow(2.0,-squarings));
+
+  // N = sum c_k X^k, D = sum c_k (-X)^k
+  const int q = 6;
+  DenseMatrix N(n,n), D(n,n), Xk(X), T(n,n);
+  double c = 1.0;
+  for(int i=0;i<n;i++) {
+    N(i,i) = 1.0;
+    D(i,i) = 1.0;
+  }
+  for(int k=1;k<=q;k++) {
+    c *= double(q-k+1)/(k*(2*q-k+1));
+    if(k>1) {
+      T.multiply(Teuchos::NO_TRANS,Teuchos::NO_TRANS,1.0,X,Xk,0.0);
+      Xk = T;
+    }
+    const double sign = (k%2==0) ? 1.0 : -1.0;
+    for(int j=0;j<n;j++)
+      for(int i=0;i<n;i++) {
+        N(i,j) += c*Xk(i,j);
+        D(i,j) += sign*c*Xk(i,j);
+      }
+  }
+
+  // exp(X) = (D^{-1} N)^(2^squarings)
+  Teuchos::LAPACK<int,double> lapack;
+  std::vector<int> pivots(n);
+  int info = 0;
+  lapack.GESV(n,n,D.values(),D.stride(),&pivots[0],N.values(),N.stride(),&info);
+  TEUCHOS_TEST_FOR_EXCEPTION(info!=0,std::runtime_error,
+                             "KrylovExponentialIntegrator: the Pade denominator is singular, info = " << info);
+  for(int s=0;s<squarings;s++) {
+    T.multiply(Teuchos::NO_TRANS,Teuchos::NO_TRANS,1.0,N,N,0.0);
+    N = T;
+  }
+  X = N;
+}
+
+// phi_k(X) e_1, the last column of exp([[X, e_1, 0], [0, 0, I_{k-1}], [0, 0, 0]])
+void phiFirstColumn(int k,const DenseMatrix & X,std::vector<double> & phi)
+{
+  const int m = X.numRows();
+
+  DenseMatrix E(m+k,m+k);
+  for(int j=0;j<m;j++)
+    for(int i=0;i<m;i++)
+      E(i,j) = X(i,j);
+  E(0,m) = 1.0;
+  for(int i=1;i<k;i++)
+    E(m+i-1,m+i) = 1.0;
+
+  exponential(E);
+
+  phi.resize(m);
+  for(int i=0;i<m;i++)
+    phi[i] = E(i,m+k-1);
+}
+
+}
+
+//**********************************************************************
+KrylovExponentialIntegrator::
+KrylovExponentialIntegrator(const Teuchos::RCP<const Thyra::ModelEvaluator<double> > & model,
+                            const Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > & lowsFactory,
+                            double shift)
+  : model_(model)
+  , lowsFactory_(lowsFactory)
+  , shift_(shift)
+  , tolerance_(1.0e-8)
+  , max_dimension_(30)
+  , t_(0.0)
+  , num_steps_(0)
+  , num_krylov_iterations_(0)
+{
+  using Teuchos::RCP;
+
+  TEUCHOS_TEST_FOR_EXCEPTION(shift_<=0.0,std::logic_error,
+                             "KrylovExponentialIntegrator: the shift " << shift_ << " is not positive!");
+
+  x_     = Thyra::createMember(model_->get_x_space());
+  x_dot_ = Thyra::createMember(model_->get_x_space());
+  v_     = Thyra::createMember(model_->get_x_space());
+  w_     = Thyra::createMember(model_->get_x_space());
+  r_     = Thyra::createMember(model_->get_f_space());
+  r_new_ = Thyra::createMember(model_->get_f_space());
+  work_  = Thyra::createMember(model_->get_f_space());
+  Thyra::assign(x_.ptr(),0.0);
+  Thyra::assign(x_dot_.ptr(),0.0);
+
+  // W = alpha M + beta K gives M and M + gamma K
+  M_op_ = model_->create_W_op();
+  S_op_ = model_->create_W_op();
+  for(int op=0;op<2;op++) {
+    Thyra::ModelEvaluatorBase::InArgs<double> inArgs = model_->createInArgs();
+    inArgs.set_x(x_);
+    inArgs.set_x_dot(x_dot_);
+    inArgs.set_t(0.0);
+    inArgs.set_alpha(1.0);
+    inArgs.set_beta(op==0 ? 0.0 : shift_);
+
+    Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = model_->createOutArgs();
+    outArgs.set_W_op(op==0 ? M_op_ : S_op_);
+
+    model_->evalModel(inArgs,outArgs);
+  }
+
+  // Dirichlet rows have no mass, give them a unit diagonal in M and in M + gamma K
+  RCP<Epetra_CrsMatrix> M = Teuchos::rcp_dynamic_cast<Epetra_CrsMatrix>(Thyra::get_Epetra_Operator(*M_op_),true);
+  RCP<Epetra_CrsMatrix> S = Teuchos::rcp_dynamic_cast<Epetra_CrsMatrix>(Thyra::get_Epetra_Operator(*S_op_),true);
+  map_ = Teuchos::rcp(new Epetra_Map(M->RowMap()));
+  for(int row=0;row<M->NumMyRows();row++) {
+    int num_entries = 0;
+    double * values = 0;
+    int * indices = 0;
+    M->ExtractMyRowView(row,num_entries,values,indices);
+
+    bool massless = true;
+    for(int k=0;k<num_entries && massless;k++)
+      massless = (values[k]==0.0);
+    if(!massless)
+      continue;
+
+    const int gid = M->RowMap().GID(row);
+    int m_col = M->ColMap().LID(gid);
+    int s_col = S->ColMap().LID(gid);
+    TEUCHOS_TEST_FOR_EXCEPTION(m_col<0 || s_col<0,std::runtime_error,
+                               "KrylovExponentialIntegrator: the massless row " << gid << " has no diagonal entry!");
+    const double one = 1.0;
+    M->ReplaceMyValues(row,1,&one,&m_col);
+    S->SumIntoMyValues(row,1,&one,&s_col);
+    dirichlet_rows_.push_back(row);
+  }
+
+  // the only factorizations
+  M_lows_ = Thyra::linearOpWithSolve<double>(*lowsFactory_,M_op_);
+  S_lows_ = Thyra::linearOpWithSolve<double>(*lowsFactory_,S_op_);
+}
+
+//**********************************************************************
+void KrylovExponentialIntegrator::
+setTolerance(double tolerance,int maxDimension)
+{
+  tolerance_ = tolerance;
+  max_dimension_ = maxDimension;
+}
+
+//**********************************************************************
+void KrylovExponentialIntegrator::
+initialize(const Thyra::VectorBase<double> & x,double t)
+{
+  Thyra::assign(x_.ptr(),x);
+  t_ = t;
+
+  // the Dirichlet rows of the residual are u - g
+  evalResidual(t_,r_.ptr());
+  {
+    Teuchos::RCP<Epetra_Vector> epetra_x = Thyra::get_Epetra_Vector(*map_,x_);
+    Teuchos::RCP<const Epetra_Vector> epetra_r = Thyra::get_Epetra_Vector(*map_,r_.getConst());
+    for(std::size_t i=0;i<dirichlet_rows_.size();i++)
+      (*epetra_x)[dirichlet_rows_[i]] -= (*epetra_r)[dirichlet_rows_[i]];
+  }
+}
+
+//**********************************************************************
+void KrylovExponentialIntegrator::
+step(double dt)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(dt<=0.0,std::logic_error,"KrylovExponentialIntegrator: the step " << dt << " is not positive!");
+
+  // the residual at both ends of the step, with the state held
+  evalResidual(t_,r_.ptr());
+  evalResidual(t_+dt,r_new_.ptr());
+  Thyra::Vp_StV(r_new_.ptr(),-1.0,*r_);
+
+  // u += h phi_1(hA) v, v = -M^{-1} r_0
+  Thyra::assign(v_.ptr(),0.0);
+  M_lows_->solve(Thyra::NOTRANS,*r_,v_.ptr());
+  applyPhi(1,dt,*v_,w_.ptr());
+  Thyra::Vp_StV(x_.ptr(),-dt,*w_);
+
+  // u += h^2 phi_2(hA) d, d = -M^{-1} (r_1 - r_0)/h, for a source that changes in time
+  if(Thyra::norm_2(*r_new_)>0.0) {
+    Thyra::assign(v_.ptr(),0.0);
+    M_lows_->solve(Thyra::NOTRANS,*r_new_,v_.ptr());
+    applyPhi(2,dt,*v_,w_.ptr());
+    Thyra::Vp_StV(x_.ptr(),-dt,*w_);
+  }
+
+  t_ += dt;
+  num_steps_++;
+}
+
+//**********************************************************************
+void KrylovExponentialIntegrator::
+evalResidual(double t,const Teuchos::Ptr<Thyra::VectorBase<double> > & r)
+{
+  Thyra::ModelEvaluatorBase::InArgs<double> inArgs = model_->createInArgs();
+  inArgs.set_x(x_);
+  inArgs.set_x_dot(x_dot_);
+  inArgs.set_t(t);
+
+  Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = model_->createOutArgs();
+  outArgs.set_f(Teuchos::rcpFromPtr(r));
+
+  model_->evalModel(inArgs,outArgs);
+}
+
+//**********************************************************************
+void KrylovExponentialIntegrator::
+applyPhi(int k,double h,const Thyra::VectorBase<double> & v,const Teuchos::Ptr<Thyra::VectorBase<double> > & y)
+{
+  const double beta = Thyra::norm_2(v);
+  if(beta==0.0) {
+    Thyra::assign(y,0.0);
+    return;
+  }
+
+  if(hessenberg_.numRows()!=max_dimension_+1)
+    hessenberg_.shape(max_dimension_+1,max_dimension_);
+  DenseMatrix & H = hessenberg_;
+
+  if(basis_.empty())
+    basis_.push_back(Thyra::createMember(model_->get_x_space()));
+  Thyra::V_StV(basis_[0].ptr(),1.0/beta,v);
+
+  std::vector<double> c, c_old;
+  int m = 0;
+  for(int j=0;;j++) {
+    // p = (M + gamma K)^{-1} M v_j, orthogonalized against the basis
+    if(int(basis_.size())<j+2)
+      basis_.push_back(Thyra::createMember(model_->get_x_space()));
+    const Teuchos::RCP<Thyra::VectorBase<double> > p = basis_[j+1];
+
+    Thyra::apply(*M_op_,Thyra::NOTRANS,*basis_[j],work_.ptr());
+    Thyra::assign(p.ptr(),0.0);
+    S_lows_->solve(Thyra::NOTRANS,*work_,p.ptr());
+    num_krylov_iterations_++;
+
+    for(int i=0;i<=j;i++) {
+      H(i,j) = Thyra::dot(*basis_[i],*p);
+      Thyra::Vp_StV(p.ptr(),-H(i,j),*basis_[i]);
+    }
+    H(j+1,j) = Thyra::norm_2(*p);
+
+    // projected phi_k(h A_m) e_1, A_m = (I - H_m^{-1})/gamma
+    m = j+1;
+    DenseMatrix H_m(m,m), X(m,m);
+    for(int col=0;col<m;col++) {
+      X(col,col) = 1.0;
+      for(int row=0;row<m;row++)
+        H_m(row,col) = H(row,col);
+    }
+    Teuchos::LAPACK<int,double> lapack;
+    std::vector<int> pivots(m);
+    int info = 0;
+    lapack.GESV(m,m,H_m.values(),H_m.stride(),&pivots[0],X.values(),X.stride(),&info);
+    TEUCHOS_TEST_FOR_EXCEPTION(info!=0,std::runtime_error,
+                               "KrylovExponentialIntegrator: the Hessenberg matrix is singular, info = " << info);
+    for(int col=0;col<m;col++)
+      for(int row=0;row<m;row++)
+        X(row,col) = (h/shift_)*((row==col ? 1.0 : 0.0)-X(row,col));
+
+    phiFirstColumn(k,X,c);
+    double change = 0.0, size = 0.0;
+    for(int i=0;i<m;i++) {
+      c[i] *= beta;
+      const double d = c[i]-(i+1<m ? c_old[i] : 0.0);
+      change += d*d;
+      size += c[i]*c[i];
+    }
+
+    // stop once the projection settles, or the space is invariant
+    if((j>0 && std::sqrt(change)<=tolerance_*std::sqrt(size)) || H(j+1,j)<=1.0e-12)
+      break;
+    TEUCHOS_TEST_FOR_EXCEPTION(m>=max_dimension_,std::runtime_error,
+                               "KrylovExponentialIntegrator: Arnoldi did not converge with " << max_dimension_
+                               << " basis vectors, raise the dimension or the shift.");
+
+    Thyra::Vt_S(p.ptr(),1.0/H(j+1,j));
+    c_old = c;
+  }
+
+  // y = V_m c
+  Thyra::assign(y,0.0);
+  for(int i=0;i<m;i++)
+    Thyra::Vp_StV(y,c[i],*basis_[i]);
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef __Step01_KrylovExponentialIntegrator_hpp__
+#define __Step01_KrylovExponentialIntegrator_hpp__
+
+#include <vector>
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_SerialDenseMatrix.hpp"
+
+#include "Thyra_LinearOpWithSolveBase.hpp"
+#include "Thyra_LinearOpWithSolveFactoryBase.hpp"
+#include "Thyra_ModelEvaluator.hpp"
+
+class Epetra_Map;
+
+namespace user_app {
+
+/** Exponential time stepping of a linear transient model,
+  * \f$ f(\dot{u}, u, t) = M \dot{u} + K u - b(t) \f$, i.e. \f$ M u' = -K u + b \f$.
+  *
+  * With the residual \f$ r_0 = f(0, u_n, t_n) \f$ and the source taken linear
+  * over the step, \f$ u_{n+1} = u_n + h \varphi_1(hA) v + h^2 \varphi_2(hA) d \f$
+  * with \f$ A = -M^{-1}K \f$, \f$ v = -M^{-1} r_0 \f$ and \f$ d \f$ the rate of
+  * change of \f$ -M^{-1} r \f$ over the step (zero for a source that does not
+  * depend on time, when the step is exact). The step may be arbitrarily large.
+  *
+  * The \f$ \varphi \f$ functions are evaluated by shift-and-invert Arnoldi:
+  * the Krylov space is built with \f$ Z = (M + \gamma K)^{-1} M = (I - \gamma A)^{-1} \f$,
+  * whose spectrum lies in (0,1] however stiff A is, so a handful of iterations
+  * reach the tolerance for any step; the small projected \f$ \varphi_k \f$ comes
+  * from the exponential of an augmented Hessenberg matrix. \f$ M \f$ and
+  * \f$ M + \gamma K \f$ are assembled and factored once.
+  *
+  * Dirichlet rows have no mass; there M gets a unit diagonal, so the boundary
+  * values obey \f$ u' = -(u - g) \f$ and stay on g once the initial state is
+  * made consistent, which initialize() does.
+  */
+class KrylovExponentialIntegrator {
+public:
+
+  /** <code>shift</code> is \f$ \gamma \f$, a fraction (about a tenth) of the typical step.
+    */
+  KrylovExponentialIntegrator(const Teuchos::RCP<const Thyra::ModelEvaluator<double> > & model,
+                              const Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > & lowsFactory,
+                              double shift);
+
+  /** Arnoldi stops once the projected solution changes by at most <code>tolerance</code>
+    * relative to its norm, and fails beyond <code>maxDimension</code> basis vectors.
+    */
+  void setTolerance(double tolerance,int maxDimension);
+
+  /** Start from <code>x</code> at time <code>t</code>, with the Dirichlet values of
+    * <code>x</code> replaced by those of the boundary conditions.
+    */
+  void initialize(const Thyra::VectorBase<double> & x,double t);
+
+  /** Advance the solution by <code>dt</code>.
+    */
+  void step(double dt);
+
+  Teuchos::RCP<const Thyra::VectorBase<double> > getSolution() const
+  { return x_; }
+
+  double getTime() const
+  { return t_; }
+
+  int numSteps() const
+  { return num_steps_; }
+
+  //! Arnoldi iterations so far, each an application of M and a solve with M + gamma K
+  int numKrylovIterations() const
+  { return num_krylov_iterations_; }
+
+private:
+
+  // r = f(0,x,t)
+  void evalResidual(double t,const Teuchos::Ptr<Thyra::VectorBase<double> > & r);
+
+  // y = phi_k(h A) v
+  void applyPhi(int k,double h,const Thyra::VectorBase<double> & v,const Teuchos::Ptr<Thyra::VectorBase<double> > & y);
+
+  Teuchos::RCP<const Thyra::ModelEvaluator<double> > model_;
+  Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory_;
+  double shift_;
+
+  double tolerance_;
+  int max_dimension_;
+
+  // M with unit Dirichlet rows, M + gamma K, and their solvers
+  Teuchos::RCP<Thyra::LinearOpBase<double> > M_op_, S_op_;
+  Teuchos::RCP<Thyra::LinearOpWithSolveBase<double> > M_lows_, S_lows_;
+
+  // the local Dirichlet rows
+  Teuchos::RCP<const Epetra_Map> map_;
+  std::vector<int> dirichlet_rows_;
+
+  Teuchos::RCP<Thyra::VectorBase<double> > x_, x_dot_, r_, r_new_, v_, w_, work_;
+  double t_;
+
+  // the Arnoldi basis and Hessenberg matrix
+  std::vector<Teuchos::RCP<Thyra::VectorBase<double> > > basis_;
+  Teuchos::SerialDenseMatrix<int,double> hessenberg_;
+
+  int num_steps_;
+  int num_krylov_iterations_;
+};
+
+}
+
+#endif
@@ -8,6 +8,8 @@
 #include "Panzer_Dimension.hpp"
 #include "Panzer_FieldLibrary.hpp"
 
+#include "Step01_IntegrationPointCache.hpp"
+
 #include <string>
 
 namespace user_app {
@@ -31,15 +33,17 @@ public:
 
 
 private:
-  typedef typename EvalT::ScalarT ScalarT;
 
-  // Simulation source
-  PHX::MDField<ScalarT,panzer::Cell,panzer::Point> result;
+  // Simulation source, passive: it does not depend on the solution
+  PHX::MDField<double,panzer::Cell,panzer::Point> result;
 
   double acoeff_;
   double bcoeff_;
   int ir_degree_;
   int ir_index_;
+
+  // the values depend on the geometry only, they are computed once per workset
+  IntegrationPointCache cache_;
 };
 
 }
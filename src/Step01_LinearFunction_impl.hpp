@@ -7,6 +7,8 @@
 #include "Panzer_Workset.hpp"
 #include "Panzer_Workset_Utilities.hpp"
 
+#include "Step01_CellPointPolicy.hpp"
+
 namespace user_app {
 
 //**********************************************************************
@@ -22,7 +24,7 @@ LinearFunction<EvalT,Traits>::LinearFunction(const std::string & name,
 
   Teuchos::RCP<PHX::DataLayout> data_layout = ir.dl_scalar;
 
-  result = PHX::MDField<ScalarT,panzer::Cell,panzer::Point>(name, data_layout);
+  result = PHX::MDField<double,panzer::Cell,panzer::Point>(name, data_layout);
   this->addEvaluatedField(result);
 
   this->setName("Linear Function("+name+")");
@@ -43,15 +45,29 @@ void LinearFunction<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupD
 template <typename EvalT,typename Traits>
 void LinearFunction<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
 { 
-  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
-    for (int point = 0; point < result.extent_int(1); ++point) {
+  const int num_points = result.extent_int(1);
 
-      const double& x = workset.int_rules[ir_index_]->ip_coordinates(cell,point,0);
-      const double& y = workset.int_rules[ir_index_]->ip_coordinates(cell,point,1);
+  const double * values = cache_.find(workset,ir_index_);
+  if(values==0) {
+    double * new_values = cache_.insert(workset,ir_index_,num_points);
+    const auto ip_coordinates = workset.int_rules[ir_index_]->ip_coordinates;
+    const double acoeff = acoeff_, bcoeff = bcoeff_;
+    Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                         KOKKOS_LAMBDA (const long cell,const long point) {
+      const double& x = ip_coordinates(cell,point,0);
+      const double& y = ip_coordinates(cell,point,1);
 
-      result(cell,point) = acoeff_*x + acoeff_*y + bcoeff_;
-    }
+      new_values[cell*num_points+point] = acoeff*x + acoeff*y + bcoeff;
+    });
+    values = new_values;
   }
+
+  // the lambda captures copies, not this
+  PHX::MDField<double,panzer::Cell,panzer::Point> result_field = result;
+  Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                       KOKKOS_LAMBDA (const long cell,const long point) {
+    result_field(cell,point) = values[cell*num_points+point];
+  });
 }
 
 //**********************************************************************
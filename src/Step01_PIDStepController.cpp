@@ -0,0 +1,66 @@
+#include "Step01_PIDStepController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+PIDStepController::
+PIDStepController(double kP,double kI,double kD)
+  : kP_(kP), kI_(kI), kD_(kD)
+  , safety_(0.9), min_factor_(0.2), max_factor_(5.0)
+  , e1_(1.0), e2_(1.0)
+  , num_errors_(0)
+{
+}
+
+//**********************************************************************
+void PIDStepController::
+setLimits(double safety,double minFactor,double maxFactor)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(safety<=0.0 || minFactor<=0.0 || minFactor>1.0 || maxFactor<1.0,
+                             std::logic_error,
+                             "PIDStepController: need a positive safety factor and 0 < min factor <= 1 <= max factor.");
+  safety_ = safety;
+  min_factor_ = minFactor;
+  max_factor_ = maxFactor;
+}
+
+//**********************************************************************
+double PIDStepController::
+acceptedStep(double dt,double error)
+{
+  // an exact step says nothing about the error, only that the step may grow
+  const double e = std::max(error,1.0e-10);
+
+  double factor = safety_*std::pow(1.0/e,kI_);
+  if(num_errors_>=1)
+    factor *= std::pow(e1_/e,kP_);
+  if(num_errors_>=2)
+    factor *= std::pow(e1_*e1_/(e*e2_),kD_);
+
+  e2_ = e1_;
+  e1_ = e;
+  num_errors_++;
+
+  return clamp(factor)*dt;
+}
+
+//**********************************************************************
+double PIDStepController::
+rejectedStep(double dt,double error,int order) const
+{
+  return clamp(std::min(safety_*std::pow(1.0/error,1.0/(order+1)),1.0))*dt;
+}
+
+//**********************************************************************
+double PIDStepController::
+clamp(double factor) const
+{
+  return std::min(std::max(factor,min_factor_),max_factor_);
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef __Step01_PIDStepController_hpp__
+#define __Step01_PIDStepController_hpp__
+
+namespace user_app {
+
+/** PID control of the time step from the normalized local error estimates
+  * \f$ e_n \f$ (\f$ e_n \le 1 \f$ accepts the step), following Valli, Carey
+  * and Coutinho:
+  * \f[ \Delta t_{n+1} = s \left(\frac{e_{n-1}}{e_n}\right)^{k_P}
+  *     \left(\frac{1}{e_n}\right)^{k_I}
+  *     \left(\frac{e_{n-1}^2}{e_n e_{n-2}}\right)^{k_D} \Delta t_n, \f]
+  * dropping the P and D factors while there are too few accepted steps. The
+  * change is limited to a factor between the minimum and the maximum. A
+  * rejected step is retried with \f$ s\, e_n^{-1/(p+1)} \Delta t_n \f$ for a
+  * method of order p.
+  */
+class PIDStepController {
+public:
+
+  PIDStepController(double kP = 0.075,double kI = 0.175,double kD = 0.01);
+
+  /** Safety factor s and the limits of the change of the step.
+    */
+  void setLimits(double safety,double minFactor,double maxFactor);
+
+  /** The next step after an accepted step <code>dt</code> with error <code>error</code>.
+    */
+  double acceptedStep(double dt,double error);
+
+  /** The retry of a rejected step <code>dt</code> with error <code>error</code>.
+    */
+  double rejectedStep(double dt,double error,int order) const;
+
+private:
+
+  double clamp(double factor) const;
+
+  double kP_, kI_, kD_;
+  double safety_, min_factor_, max_factor_;
+
+  // the errors of the last two accepted steps, e_{n-1} and e_{n-2}
+  double e1_, e2_;
+  int num_errors_;
+};
+
+}
+
+#endif
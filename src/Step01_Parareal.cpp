@@ -0,0 +1,120 @@
+#include "Step01_Parareal.hpp"
+
+#include <algorithm>
+
+#include "Teuchos_Assert.hpp"
+#include "Teuchos_CommHelpers.hpp"
+
+#include "Thyra_SpmdVectorBase.hpp"
+#include "Thyra_VectorStdOps.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+Parareal::
+Parareal(const Teuchos::RCP<const Teuchos::Comm<int> > & timeComm,
+         const Teuchos::RCP<const Thyra::VectorSpaceBase<double> > & space,
+         const Propagator & coarse,
+         const Propagator & fine)
+  : time_comm_(timeComm)
+  , space_(space)
+  , coarse_(coarse)
+  , fine_(fine)
+  , tolerance_(1.0e-8)
+  , max_iterations_(timeComm->getSize())
+  , num_iterations_(0)
+  , num_fine_solves_(0)
+{
+}
+
+//**********************************************************************
+void Parareal::
+setTolerance(double tolerance,int maxIterations)
+{
+  tolerance_ = tolerance;
+  max_iterations_ = maxIterations;
+}
+
+//**********************************************************************
+void Parareal::
+integrate(const Thyra::VectorBase<double> & x0,double t0,double tFinal,
+          const Teuchos::Ptr<Thyra::VectorBase<double> > & x)
+{
+  const int n = time_comm_->getRank();
+  const int num_slices = time_comm_->getSize();
+  const double t_begin = t0+(tFinal-t0)*n/num_slices;
+  const double t_end = (n+1==num_slices) ? tFinal : t0+(tFinal-t0)*(n+1)/num_slices;
+
+  // the start of this slice, G and F of it, and its new end
+  Teuchos::RCP<Thyra::VectorBase<double> > u = Thyra::createMember(space_);
+  Teuchos::RCP<Thyra::VectorBase<double> > g = Thyra::createMember(space_);
+  Teuchos::RCP<Thyra::VectorBase<double> > g_new = Thyra::createMember(space_);
+  Teuchos::RCP<Thyra::VectorBase<double> > f = Thyra::createMember(space_);
+  Teuchos::RCP<Thyra::VectorBase<double> > end = Thyra::createMember(space_);
+
+  // iteration 0, the coarse sweep
+  if(n==0)
+    Thyra::assign(u.ptr(),x0);
+  else
+    receive(n-1,*u);
+  coarse_(*u,t_begin,t_end,g.ptr());
+  Thyra::assign(x,*g);
+  if(n+1<num_slices)
+    send(*x,n+1);
+
+  num_iterations_ = 0;
+  num_fine_solves_ = 0;
+  for(int k=0;k<std::min(max_iterations_,num_slices);k++) {
+
+    // the start of slice n has not moved since the last iteration once n < k
+    if(n>=k) {
+      fine_(*u,t_begin,t_end,f.ptr());
+      num_fine_solves_++;
+    }
+
+    // the correction sweep: U_{n+1} = G(U_n) + F(U_n^old) - G(U_n^old)
+    if(n>0)
+      receive(n-1,*u);
+    if(n>k)
+      coarse_(*u,t_begin,t_end,g_new.ptr());
+    else
+      Thyra::assign(g_new.ptr(),*g);
+
+    Thyra::V_VmV(end.ptr(),*f,*g);
+    Thyra::Vp_V(end.ptr(),*g_new);
+    std::swap(g,g_new);
+
+    Thyra::V_VmV(g_new.ptr(),*end,*x);
+    const double change = Thyra::norm_2(*g_new);
+    Thyra::assign(x,*end);
+
+    if(n+1<num_slices)
+      send(*x,n+1);
+    num_iterations_++;
+
+    double max_change = 0.0;
+    Teuchos::reduceAll(*time_comm_,Teuchos::REDUCE_MAX,change,Teuchos::ptr(&max_change));
+    if(max_change<=tolerance_)
+      break;
+  }
+}
+
+//**********************************************************************
+void Parareal::
+send(const Thyra::VectorBase<double> & x,int dest) const
+{
+  Teuchos::ArrayRCP<const double> values;
+  Teuchos::rcp_dynamic_cast<const Thyra::SpmdVectorBase<double> >(Teuchos::rcpFromRef(x),true)->getLocalData(Teuchos::ptr(&values));
+  Teuchos::send<int,double>(*time_comm_,values.size(),values.getRawPtr(),dest);
+}
+
+//**********************************************************************
+void Parareal::
+receive(int source,Thyra::VectorBase<double> & x) const
+{
+  Teuchos::ArrayRCP<double> values;
+  Teuchos::rcp_dynamic_cast<Thyra::SpmdVectorBase<double> >(Teuchos::rcpFromRef(x),true)->getNonconstLocalData(Teuchos::ptr(&values));
+  Teuchos::receive<int,double>(*time_comm_,source,values.size(),values.getRawPtr());
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef __Step01_Parareal_hpp__
+#define __Step01_Parareal_hpp__
+
+#include <functional>
+
+#include "Teuchos_Comm.hpp"
+#include "Teuchos_RCP.hpp"
+
+#include "Thyra_VectorBase.hpp"
+#include "Thyra_VectorSpaceBase.hpp"
+
+namespace user_app {
+
+/** Parareal integration in time across the ranks of a time communicator.
+  *
+  * The time interval is split into one slice per rank of the time
+  * communicator; each rank is the root of a group of ranks (its space
+  * communicator) that holds a full copy of the spatial problem, and the
+  * ranks with the same spatial rank in every group form one time
+  * communicator. The groups must decompose the mesh the same way, so that
+  * a state vector can be handed from one slice to the next as the raw local
+  * values of every spatial rank.
+  *
+  * With a cheap coarse propagator G and the accurate fine propagator F, the
+  * iteration
+  * \f[ U_{n+1}^{k+1} = G(U_n^{k+1}) + F(U_n^k) - G(U_n^k) \f]
+  * runs the F of all slices concurrently and only the G sweep in sequence.
+  * Slice n is exact after n iterations, so the slices before the iteration
+  * count skip their fine solve; the iteration stops once no slice end moves
+  * by more than the tolerance (2-norm), and after at most one iteration per
+  * slice, which reproduces the sequential fine solution.
+  */
+class Parareal {
+public:
+
+  //! Propagate x0 at t0 to x1 at t1
+  typedef std::function<void(const Thyra::VectorBase<double> & x0,double t0,double t1,
+                             const Teuchos::Ptr<Thyra::VectorBase<double> > & x1)> Propagator;
+
+  Parareal(const Teuchos::RCP<const Teuchos::Comm<int> > & timeComm,
+           const Teuchos::RCP<const Thyra::VectorSpaceBase<double> > & space,
+           const Propagator & coarse,
+           const Propagator & fine);
+
+  /** Stop once the slice ends move by at most <code>tolerance</code>, or after
+    * <code>maxIterations</code> iterations.
+    */
+  void setTolerance(double tolerance,int maxIterations);
+
+  /** Integrate from <code>x0</code> at <code>t0</code> to <code>tFinal</code>;
+    * <code>x</code> is the solution at the end of this rank's slice, i.e.
+    * the last rank holds the solution at <code>tFinal</code>.
+    */
+  void integrate(const Thyra::VectorBase<double> & x0,double t0,double tFinal,
+                 const Teuchos::Ptr<Thyra::VectorBase<double> > & x);
+
+  int numIterations() const
+  { return num_iterations_; }
+
+  //! Fine propagations done by this slice
+  int numFineSolves() const
+  { return num_fine_solves_; }
+
+private:
+
+  void send(const Thyra::VectorBase<double> & x,int dest) const;
+
+  void receive(int source,Thyra::VectorBase<double> & x) const;
+
+  Teuchos::RCP<const Teuchos::Comm<int> > time_comm_;
+  Teuchos::RCP<const Thyra::VectorSpaceBase<double> > space_;
+  Propagator coarse_, fine_;
+
+  double tolerance_;
+  int max_iterations_;
+
+  int num_iterations_;
+  int num_fine_solves_;
+};
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __Step01_PassiveConstant_hpp__
+#define __Step01_PassiveConstant_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+#include "Phalanx_MDField.hpp"
+
+namespace user_app {
+
+/** A constant field stored as <code>double</code> for every evaluation type.
+  *
+  * The passive counterpart of panzer::Constant: the value does not depend on the
+  * solution, so in a Jacobian evaluation there are no derivative arrays to store
+  * or to propagate.
+  *
+  * Parameters are those of panzer::Constant: "Name", "Value" and "Data Layout".
+  */
+template<typename EvalT, typename Traits>
+class PassiveConstant : public PHX::EvaluatorWithBaseImpl<Traits>,
+                        public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    PassiveConstant(const Teuchos::ParameterList & p);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+
+  PHX::MDField<double> constant;
+
+  double value_;
+};
+
+}
+
+#endif
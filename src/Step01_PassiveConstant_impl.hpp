@@ -0,0 +1,41 @@
+#ifndef __Step01_PassiveConstant_impl_hpp__
+#define __Step01_PassiveConstant_impl_hpp__
+
+#include "Teuchos_ParameterList.hpp"
+
+#include "Phalanx_DataLayout.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+PassiveConstant<EvalT,Traits>::PassiveConstant(const Teuchos::ParameterList & p)
+  : value_(p.get<double>("Value"))
+{
+  constant = PHX::MDField<double>(p.get<std::string>("Name"),
+                                  p.get<Teuchos::RCP<PHX::DataLayout> >("Data Layout"));
+  this->addEvaluatedField(constant);
+
+  this->setName("Passive Constant("+constant.fieldTag().name()+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void PassiveConstant<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                          PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(constant,fm);
+
+  // the value never changes, so it is set once here
+  constant.deep_copy(value_);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void PassiveConstant<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{ }
+
+//**********************************************************************
+}
+
+#endif
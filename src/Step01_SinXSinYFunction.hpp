@@ -8,7 +8,10 @@
 #include "Panzer_Dimension.hpp"
 #include "Panzer_FieldLibrary.hpp"
 
+#include "Step01_IntegrationPointCache.hpp"
+
 #include <string>
+#include <vector>
 
 namespace user_app {
     
@@ -31,15 +34,33 @@ public:
 
 
 private:
-  typedef typename EvalT::ScalarT ScalarT;
 
-  // Simulation source
-  PHX::MDField<ScalarT,panzer::Cell,panzer::Point> result;
+  /** Fill the (Cell,Point) values of a workset. The source is a product of a function
+    * of x and one of y, so each is evaluated once per distinct coordinate, over a
+    * contiguous array, and the point values are formed as an outer product.
+    */
+  void computeSeparable(const panzer::Workset & workset,double * values);
+
+  /** Distinct values of <code>coords</code> in <code>unique</code>, and for every entry
+    * the index of its value in <code>which</code>.
+    */
+  void uniqueCoordinates(const std::vector<double> & coords,
+                         std::vector<double> & unique,std::vector<int> & which);
+
+  // Simulation source, passive: it does not depend on the solution
+  PHX::MDField<double,panzer::Cell,panzer::Point> result;
 
   double xperiod_;
   double yperiod_;
   int ir_degree_;
   int ir_index_;
+
+  // the values depend on the geometry only, they are computed once per workset
+  IntegrationPointCache cache_;
+
+  // scratch of computeSeparable
+  std::vector<double> x_, y_, unique_x_, unique_y_, sin_x_, sin_y_;
+  std::vector<int> which_x_, which_y_, order_;
 };
 
 }
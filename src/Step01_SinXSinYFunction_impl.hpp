@@ -1,12 +1,15 @@
 #ifndef __Step01_SinXSinYFunction_impl_hpp__
 #define __Step01_SinXSinYFunction_impl_hpp__
 
+#include <algorithm>
 #include <cmath>
 
 #include "Panzer_BasisIRLayout.hpp"
 #include "Panzer_Workset.hpp"
 #include "Panzer_Workset_Utilities.hpp"
 
+#include "Step01_CellPointPolicy.hpp"
+
 namespace user_app {
 
 //**********************************************************************
@@ -22,7 +25,7 @@ SinXSinYFunction<EvalT,Traits>::SinXSinYFunction(const std::string & name,
 
   Teuchos::RCP<PHX::DataLayout> data_layout = ir.dl_scalar;
 
-  result = PHX::MDField<ScalarT,panzer::Cell,panzer::Point>(name, data_layout);
+  result = PHX::MDField<double,panzer::Cell,panzer::Point>(name, data_layout);
   this->addEvaluatedField(result);
 
   this->setName("SinXSinY Function("+name+")");
@@ -43,14 +46,90 @@ void SinXSinYFunction<EvalT,Traits>::postRegistrationSetup(typename Traits::Setu
 template <typename EvalT,typename Traits>
 void SinXSinYFunction<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
 { 
-  for (panzer::index_t cell = 0; cell < workset.num_cells; ++cell) {
-    for (int point = 0; point < result.extent_int(1); ++point) {
+  const int num_points = result.extent_int(1);
+
+  const double * values = cache_.find(workset,ir_index_);
+  if(values==0) {
+    double * new_values = cache_.insert(workset,ir_index_,num_points);
+    computeSeparable(workset,new_values);
+    values = new_values;
+  }
+
+  // the lambda captures copies, not this
+  PHX::MDField<double,panzer::Cell,panzer::Point> result_field = result;
+  Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                       KOKKOS_LAMBDA (const long cell,const long point) {
+    result_field(cell,point) = values[cell*num_points+point];
+  });
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void SinXSinYFunction<EvalT,Traits>::computeSeparable(const panzer::Workset & workset,double * values)
+{
+  const int num_points = result.extent_int(1);
+  const int n = workset.num_cells*num_points;
+
+  // the coordinates, contiguous
+  x_.resize(n);
+  y_.resize(n);
+  {
+    const auto ip_coordinates = workset.int_rules[ir_index_]->ip_coordinates;
+    double * x = n>0 ? &x_[0] : 0;
+    double * y = n>0 ? &y_[0] : 0;
+    Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                         KOKKOS_LAMBDA (const long cell,const long point) {
+      x[cell*num_points+point] = ip_coordinates(cell,point,0);
+      y[cell*num_points+point] = ip_coordinates(cell,point,1);
+    });
+  }
+
+  // on axis aligned quads there are a few distinct x and y values per workset
+  uniqueCoordinates(x_,unique_x_,which_x_);
+  uniqueCoordinates(y_,unique_y_,which_y_);
+
+  // one sin per distinct coordinate, in loops the compiler can vectorize
+  const double kx = 2*M_PI*xperiod_;
+  const double ky = 2*M_PI*yperiod_;
+  const int nx = unique_x_.size();
+  const int ny = unique_y_.size();
+  sin_x_.resize(nx);
+  sin_y_.resize(ny);
+  for (int i = 0; i < nx; ++i)
+    sin_x_[i] = std::sin(kx*unique_x_[i]);
+  for (int j = 0; j < ny; ++j)
+    sin_y_[j] = std::sin(ky*unique_y_[j]);
+
+  const double * sin_x = nx>0 ? &sin_x_[0] : 0;
+  const double * sin_y = ny>0 ? &sin_y_[0] : 0;
+  const int * which_x = n>0 ? &which_x_[0] : 0;
+  const int * which_y = n>0 ? &which_y_[0] : 0;
+  Kokkos::parallel_for(Kokkos::RangePolicy<CellPointExecutionSpace>(0,n),
+                       KOKKOS_LAMBDA (const int p) {
+    values[p] = sin_x[which_x[p]]*sin_y[which_y[p]];
+  });
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void SinXSinYFunction<EvalT,Traits>::uniqueCoordinates(const std::vector<double> & coords,
+                                                       std::vector<double> & unique,std::vector<int> & which)
+{
+  const int n = coords.size();
 
-      const double& x = workset.int_rules[ir_index_]->ip_coordinates(cell,point,0);
-      const double& y = workset.int_rules[ir_index_]->ip_coordinates(cell,point,1);
+  order_.resize(n);
+  for (int p = 0; p < n; ++p)
+    order_[p] = p;
+  std::sort(order_.begin(),order_.end(),[&](int a,int b) { return coords[a]<coords[b]; });
 
-      result(cell,point) = sin(2*M_PI*xperiod_*x)*sin(2*M_PI*yperiod_*y);
-    }
+  // only bitwise equal values are merged, so the result is exact on any mesh
+  unique.clear();
+  which.resize(n);
+  for (int k = 0; k < n; ++k) {
+    const double c = coords[order_[k]];
+    if(unique.empty() || c!=unique.back())
+      unique.push_back(c);
+    which[order_[k]] = unique.size()-1;
   }
 }
 
@@ -0,0 +1,213 @@
+#include "Step01_TabulatedData.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+namespace {
+
+// nearest points used by the inverse distance weighting
+const int num_neighbors = 4;
+
+}
+
+//**********************************************************************
+Teuchos::RCP<const TabulatedData> TabulatedData::open(const std::string & file_name)
+{
+  // weak references, a file is unmapped when its last user lets go of it
+  static std::map<std::string,Teuchos::RCP<const TabulatedData> > opened;
+
+  std::map<std::string,Teuchos::RCP<const TabulatedData> >::iterator itr = opened.find(file_name);
+  if(itr!=opened.end() && itr->second.is_valid_ptr())
+    return itr->second.create_strong();
+
+  Teuchos::RCP<const TabulatedData> data = Teuchos::rcp(new TabulatedData(file_name));
+  opened[file_name] = data.create_weak();
+  return data;
+}
+
+//**********************************************************************
+TabulatedData::TabulatedData(const std::string & file_name)
+  : file_name_(file_name)
+  , mapping_(MAP_FAILED)
+  , mapping_size_(0)
+  , grid_(true)
+  , num_values_(0)
+  , nx_(0), ny_(0)
+  , x0_(0.0), y0_(0.0), dx_(0.0), dy_(0.0)
+  , values_(0)
+  , points_(0)
+{
+  const int fd = ::open(file_name.c_str(),O_RDONLY);
+  TEUCHOS_TEST_FOR_EXCEPTION(fd<0,std::runtime_error,
+                             "TabulatedData: cannot open \"" << file_name << "\"!");
+
+  struct stat st;
+  const bool have_size = ::fstat(fd,&st)==0;
+  mapping_size_ = have_size ? st.st_size : 0;
+  if(mapping_size_>0)
+    mapping_ = ::mmap(0,mapping_size_,PROT_READ,MAP_PRIVATE,fd,0);
+  ::close(fd);
+  TEUCHOS_TEST_FOR_EXCEPTION(mapping_==MAP_FAILED,std::runtime_error,
+                             "TabulatedData: cannot map \"" << file_name << "\"!");
+
+  const std::size_t num_words = mapping_size_/8;
+  const char * bytes = static_cast<const char *>(mapping_);
+  const long * words = static_cast<const long *>(mapping_);
+  TEUCHOS_TEST_FOR_EXCEPTION(num_words<2 || std::memcmp(bytes,"STEP01TB",8)!=0,std::runtime_error,
+                             "TabulatedData: \"" << file_name << "\" is not a tabulated data file!");
+
+  grid_ = words[1]==0;
+  TEUCHOS_TEST_FOR_EXCEPTION(words[1]!=0 && words[1]!=1,std::runtime_error,
+                             "TabulatedData: unknown kind " << words[1] << " in \"" << file_name << "\"!");
+
+  if(grid_) {
+    TEUCHOS_TEST_FOR_EXCEPTION(num_words<8,std::runtime_error,
+                               "TabulatedData: truncated header in \"" << file_name << "\"!");
+    nx_ = words[2];
+    ny_ = words[3];
+    const double * header = reinterpret_cast<const double *>(words+4);
+    x0_ = header[0];
+    y0_ = header[1];
+    dx_ = header[2];
+    dy_ = header[3];
+    TEUCHOS_TEST_FOR_EXCEPTION(nx_<1 || ny_<1 || dx_<=0.0 || dy_<=0.0,std::runtime_error,
+                               "TabulatedData: bad grid in \"" << file_name << "\"!");
+
+    num_values_ = nx_*ny_;
+    TEUCHOS_TEST_FOR_EXCEPTION(num_words<8+num_values_,std::runtime_error,
+                               "TabulatedData: \"" << file_name << "\" holds fewer than " << num_values_ << " values!");
+    values_ = reinterpret_cast<const double *>(words+8);
+  }
+  else {
+    TEUCHOS_TEST_FOR_EXCEPTION(num_words<3 || words[2]<1,std::runtime_error,
+                               "TabulatedData: no points in \"" << file_name << "\"!");
+    num_values_ = words[2];
+    TEUCHOS_TEST_FOR_EXCEPTION(num_words<3+3*num_values_,std::runtime_error,
+                               "TabulatedData: \"" << file_name << "\" holds fewer than " << num_values_ << " points!");
+    points_ = reinterpret_cast<const double *>(words+3);
+
+    tree_.resize(num_values_);
+    for(std::size_t i=0;i<num_values_;i++)
+      tree_[i] = i;
+    buildTree(0,num_values_,0);
+  }
+}
+
+//**********************************************************************
+TabulatedData::~TabulatedData()
+{
+  if(mapping_!=MAP_FAILED)
+    ::munmap(mapping_,mapping_size_);
+}
+
+//**********************************************************************
+double TabulatedData::value(double x,double y) const
+{
+  return grid_ ? gridValue(x,y) : scatteredValue(x,y);
+}
+
+//**********************************************************************
+double TabulatedData::gridValue(double x,double y) const
+{
+  // cell of the point and the local coordinates in it, clamped to the grid
+  double s = (x-x0_)/dx_;
+  double t = (y-y0_)/dy_;
+  s = std::min(std::max(s,0.0),double(nx_-1));
+  t = std::min(std::max(t,0.0),double(ny_-1));
+
+  const long i = std::min(long(s),std::max(nx_-2,0L));
+  const long j = std::min(long(t),std::max(ny_-2,0L));
+  const long i1 = std::min(i+1,nx_-1);
+  const long j1 = std::min(j+1,ny_-1);
+  s -= i;
+  t -= j;
+
+  return (1.0-s)*(1.0-t)*values_[i +nx_*j ] + s*(1.0-t)*values_[i1+nx_*j ]
+       + (1.0-s)*t      *values_[i +nx_*j1] + s*t      *values_[i1+nx_*j1];
+}
+
+//**********************************************************************
+double TabulatedData::scatteredValue(double x,double y) const
+{
+  int nearest[num_neighbors];
+  double distances[num_neighbors];
+  int found = 0;
+  searchTree(0,num_values_,0,x,y,nearest,distances,found);
+
+  // on a data point take its value, otherwise weight by the inverse squared distance
+  double sum = 0.0, weights = 0.0;
+  for(int k=0;k<found;k++) {
+    if(distances[k]==0.0)
+      return points_[3*nearest[k]+2];
+    const double w = 1.0/distances[k];
+    sum += w*points_[3*nearest[k]+2];
+    weights += w;
+  }
+  return sum/weights;
+}
+
+//**********************************************************************
+void TabulatedData::buildTree(int lo,int hi,int depth)
+{
+  if(hi-lo<=1)
+    return;
+
+  const int mid = (lo+hi)/2;
+  const int axis = depth%2;
+  std::nth_element(tree_.begin()+lo,tree_.begin()+mid,tree_.begin()+hi,
+                   [&](int a,int b) { return points_[3*a+axis]<points_[3*b+axis]; });
+
+  buildTree(lo,mid,depth+1);
+  buildTree(mid+1,hi,depth+1);
+}
+
+//**********************************************************************
+void TabulatedData::searchTree(int lo,int hi,int depth,double x,double y,
+                               int * nearest,double * distances,int & found) const
+{
+  if(hi<=lo)
+    return;
+
+  const int mid = (lo+hi)/2;
+  const int p = tree_[mid];
+
+  // insert the median point in the sorted list of the nearest (squared distances)
+  const double d = (pointX(p)-x)*(pointX(p)-x) + (pointY(p)-y)*(pointY(p)-y);
+  if(found<num_neighbors || d<distances[found-1]) {
+    int k = found<num_neighbors ? found++ : found-1;
+    for(;k>0 && distances[k-1]>d;k--) {
+      distances[k] = distances[k-1];
+      nearest[k] = nearest[k-1];
+    }
+    distances[k] = d;
+    nearest[k] = p;
+  }
+
+  // the side of the split holding the point first, the other if it can hold a nearer one
+  const double delta = (depth%2==0) ? x-pointX(p) : y-pointY(p);
+  if(delta<0.0) {
+    searchTree(lo,mid,depth+1,x,y,nearest,distances,found);
+    if(found<num_neighbors || delta*delta<distances[found-1])
+      searchTree(mid+1,hi,depth+1,x,y,nearest,distances,found);
+  }
+  else {
+    searchTree(mid+1,hi,depth+1,x,y,nearest,distances,found);
+    if(found<num_neighbors || delta*delta<distances[found-1])
+      searchTree(lo,mid,depth+1,x,y,nearest,distances,found);
+  }
+}
+
+}
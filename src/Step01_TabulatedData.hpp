@@ -0,0 +1,85 @@
+#ifndef __Step01_TabulatedData_hpp__
+#define __Step01_TabulatedData_hpp__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Teuchos_RCP.hpp"
+
+namespace user_app {
+
+/** Measured data of a source, memory mapped from a binary file, and interpolated
+  * at arbitrary points.
+  *
+  * The file is native endian and made of 8 byte words:
+  *   - the magic "STEP01TB" and an int64 kind, 0 for a grid, 1 for scattered points
+  *   - a grid: int64 nx, ny, doubles x0, y0, dx, dy, then the nx*ny values with x
+  *     running fastest; it is interpolated bilinearly (constant beyond the edges),
+  *     O(1) per point
+  *   - scattered points: int64 n, then n (x,y,value) triples; they are indexed by a
+  *     k-d tree built when the file is opened, and interpolated by inverse distance
+  *     weighting of the nearest points, O(log n) per point
+  *
+  * The values are read in place from the mapping, only the k-d tree is held in
+  * memory. value() is const and may be called concurrently.
+  */
+class TabulatedData {
+public:
+
+  /** The data of a file. Every caller asking for the same file shares one mapping
+    * and one index while any of them holds on to it.
+    */
+  static Teuchos::RCP<const TabulatedData> open(const std::string & file_name);
+
+  TabulatedData(const std::string & file_name);
+
+  ~TabulatedData();
+
+  //! Interpolated value at (x,y)
+  double value(double x,double y) const;
+
+  //! Number of grid values or scattered points
+  std::size_t size() const
+  { return num_values_; }
+
+  const std::string & fileName() const
+  { return file_name_; }
+
+private:
+
+  TabulatedData(const TabulatedData &);
+  TabulatedData & operator=(const TabulatedData &);
+
+  double gridValue(double x,double y) const;
+  double scatteredValue(double x,double y) const;
+
+  // k-d tree over the points [lo,hi) of tree_, split in coordinate depth%2
+  void buildTree(int lo,int hi,int depth);
+  void searchTree(int lo,int hi,int depth,double x,double y,
+                  int * nearest,double * distances,int & found) const;
+
+  double pointX(int i) const { return points_[3*i]; }
+  double pointY(int i) const { return points_[3*i+1]; }
+
+  std::string file_name_;
+
+  void * mapping_;
+  std::size_t mapping_size_;
+
+  bool grid_;
+  std::size_t num_values_;
+
+  // the grid
+  long nx_, ny_;
+  double x0_, y0_, dx_, dy_;
+  const double * values_;
+
+  // the scattered points, (x,y,value) triples, and the k-d tree as a permutation
+  const double * points_;
+  std::vector<int> tree_;
+};
+
+}
+
+#endif
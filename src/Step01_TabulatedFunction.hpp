@@ -0,0 +1,51 @@
+#ifndef __Step01_TabulatedFunction_hpp__
+#define __Step01_TabulatedFunction_hpp__
+
+#include "Phalanx_Evaluator_WithBaseImpl.hpp"
+#include "Phalanx_Evaluator_Derived.hpp"
+#include "Phalanx_FieldManager.hpp"
+
+#include "Panzer_Dimension.hpp"
+#include "Panzer_FieldLibrary.hpp"
+
+#include "Step01_IntegrationPointCache.hpp"
+#include "Step01_TabulatedData.hpp"
+
+#include <string>
+
+namespace user_app {
+
+/** A source interpolated from measured data at the integration points, see
+  * TabulatedData for the file format and the interpolation.
+  */
+template<typename EvalT, typename Traits>
+class TabulatedFunction : public PHX::EvaluatorWithBaseImpl<Traits>,
+                          public PHX::EvaluatorDerived<EvalT, Traits>  {
+
+public:
+    TabulatedFunction(const std::string & name,
+                      const Teuchos::RCP<const TabulatedData> & data,
+                      const panzer::IntegrationRule & ir);
+
+    void postRegistrationSetup(typename Traits::SetupData d,
+                               PHX::FieldManager<Traits>& fm);
+
+    void evaluateFields(typename Traits::EvalData d);
+
+
+private:
+
+  // Simulation source, passive: it does not depend on the solution
+  PHX::MDField<double,panzer::Cell,panzer::Point> result;
+
+  Teuchos::RCP<const TabulatedData> data_;
+  int ir_degree_;
+  int ir_index_;
+
+  // the values depend on the geometry only, they are interpolated once per workset
+  IntegrationPointCache cache_;
+};
+
+}
+
+#endif
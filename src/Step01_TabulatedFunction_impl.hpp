@@ -0,0 +1,67 @@
+#ifndef __Step01_TabulatedFunction_impl_hpp__
+#define __Step01_TabulatedFunction_impl_hpp__
+
+#include "Panzer_BasisIRLayout.hpp"
+#include "Panzer_Workset.hpp"
+#include "Panzer_Workset_Utilities.hpp"
+
+#include "Step01_CellPointPolicy.hpp"
+
+namespace user_app {
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+TabulatedFunction<EvalT,Traits>::TabulatedFunction(const std::string & name,
+                                                   const Teuchos::RCP<const TabulatedData> & data,
+                                                   const panzer::IntegrationRule & ir)
+  : data_(data)
+  , ir_degree_(ir.cubature_degree)
+{
+  Teuchos::RCP<PHX::DataLayout> data_layout = ir.dl_scalar;
+
+  result = PHX::MDField<double,panzer::Cell,panzer::Point>(name, data_layout);
+  this->addEvaluatedField(result);
+
+  this->setName("Tabulated Function("+name+" from "+data_->fileName()+")");
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void TabulatedFunction<EvalT,Traits>::postRegistrationSetup(typename Traits::SetupData sd,
+                                                           PHX::FieldManager<Traits>& fm)
+{
+  this->utils.setFieldData(result,fm);
+
+  ir_index_ = panzer::getIntegrationRuleIndex(ir_degree_,(*sd.worksets_)[0]);
+}
+
+//**********************************************************************
+template <typename EvalT,typename Traits>
+void TabulatedFunction<EvalT,Traits>::evaluateFields(typename Traits::EvalData workset)
+{
+  const int num_points = result.extent_int(1);
+
+  const double * values = cache_.find(workset,ir_index_);
+  if(values==0) {
+    double * new_values = cache_.insert(workset,ir_index_,num_points);
+    const auto ip_coordinates = workset.int_rules[ir_index_]->ip_coordinates;
+    const TabulatedData * data = data_.get();
+    Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                         KOKKOS_LAMBDA (const long cell,const long point) {
+      new_values[cell*num_points+point] = data->value(ip_coordinates(cell,point,0),ip_coordinates(cell,point,1));
+    });
+    values = new_values;
+  }
+
+  // the lambda captures copies, not this
+  PHX::MDField<double,panzer::Cell,panzer::Point> result_field = result;
+  Kokkos::parallel_for(cellPointPolicy(workset.num_cells,num_points),
+                       KOKKOS_LAMBDA (const long cell,const long point) {
+    result_field(cell,point) = values[cell*num_points+point];
+  });
+}
+
+//**********************************************************************
+}
+
+#endif
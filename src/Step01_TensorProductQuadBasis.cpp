@@ -0,0 +1,177 @@
+#include "Step01_TensorProductQuadBasis.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Teuchos_Assert.hpp"
+
+namespace user_app {
+
+namespace {
+
+// distinct values of one coordinate of the points, sorted
+std::vector<double> distinctCoordinates(const std::vector<double> & points,int num_points,int d)
+{
+  std::vector<double> coords;
+  for(int q=0;q<num_points;q++)
+    coords.push_back(points[2*q+d]);
+  std::sort(coords.begin(),coords.end());
+
+  std::vector<double> distinct;
+  for(std::size_t k=0;k<coords.size();k++)
+    if(distinct.empty() || std::fabs(coords[k]-distinct.back())>1.0e-12)
+      distinct.push_back(coords[k]);
+  return distinct;
+}
+
+int findCoordinate(const std::vector<double> & coords,double x)
+{
+  for(std::size_t k=0;k<coords.size();k++)
+    if(std::fabs(coords[k]-x)<=1.0e-12)
+      return k;
+  return -1;
+}
+
+// normalize f to unit length with its largest entry positive, return the factor taken out
+double normalize(std::vector<double> & f)
+{
+  double norm = 0.0, largest = 0.0;
+  for(std::size_t k=0;k<f.size();k++) {
+    norm += f[k]*f[k];
+    if(std::fabs(f[k])>std::fabs(largest))
+      largest = f[k];
+  }
+  norm = std::sqrt(norm);
+  if(largest<0.0)
+    norm = -norm;
+
+  for(std::size_t k=0;k<f.size();k++)
+    f[k] /= norm;
+  return norm;
+}
+
+// index of f among the (normalized) factors, which are stored row by row; adds f if it is new
+int findOrAddFactor(std::vector<double> & factors,const std::vector<double> & f)
+{
+  const int n = f.size();
+  const int num_factors = factors.size()/n;
+  for(int k=0;k<num_factors;k++) {
+    double diff = 0.0;
+    for(int i=0;i<n;i++)
+      diff = std::max(diff,std::fabs(factors[k*n+i]-f[i]));
+    if(diff<1.0e-8)
+      return k;
+  }
+  factors.insert(factors.end(),f.begin(),f.end());
+  return num_factors;
+}
+
+}
+
+//**********************************************************************
+TensorProductQuadBasis::
+TensorProductQuadBasis(int num_basis,int num_points,
+                       const std::vector<double> & ref_points,
+                       const std::vector<double> & ref_values,
+                       const std::vector<double> & ref_grads)
+  : valid_(false)
+  , num_basis_(num_basis)
+  , num_points_(num_points)
+  , nq_x_(0), nq_y_(0), nb_x_(0), nb_y_(0)
+{
+  TEUCHOS_ASSERT(int(ref_points.size())==2*num_points);
+  TEUCHOS_ASSERT(int(ref_values.size())==num_basis*num_points);
+  TEUCHOS_ASSERT(int(ref_grads.size())==2*num_basis*num_points);
+
+  // the cubature must be a tensor product of two 1D rules
+  const std::vector<double> xi = distinctCoordinates(ref_points,num_points,0);
+  const std::vector<double> eta = distinctCoordinates(ref_points,num_points,1);
+  nq_x_ = xi.size();
+  nq_y_ = eta.size();
+  if(nq_x_*nq_y_!=num_points)
+    return;
+
+  point_.assign(num_points,-1);
+  for(int q=0;q<num_points;q++) {
+    const int i = findCoordinate(xi,ref_points[2*q]);
+    const int j = findCoordinate(eta,ref_points[2*q+1]);
+    if(i<0 || j<0)
+      return;
+    point_[i+nq_x_*j] = q;
+  }
+  if(std::find(point_.begin(),point_.end(),-1)!=point_.end())
+    return;
+
+  // split every basis function M(i,j) = phi_b(xi_i,eta_j) into u_i v_j
+  a_.resize(num_basis);
+  c_.resize(num_basis);
+  scale_.resize(num_basis);
+  for(int b=0;b<num_basis;b++) {
+    const double * M = &ref_values[b*num_points];
+
+    int i_max = 0, j_max = 0;
+    for(int i=0;i<nq_x_;i++)
+      for(int j=0;j<nq_y_;j++)
+        if(std::fabs(M[point_[i+nq_x_*j]])>std::fabs(M[point_[i_max+nq_x_*j_max]])) {
+          i_max = i;
+          j_max = j;
+        }
+    const double pivot = M[point_[i_max+nq_x_*j_max]];
+    if(pivot==0.0)
+      return;
+
+    std::vector<double> u(nq_x_), v(nq_y_);
+    for(int i=0;i<nq_x_;i++)
+      u[i] = M[point_[i+nq_x_*j_max]];
+    for(int j=0;j<nq_y_;j++)
+      v[j] = M[point_[i_max+nq_x_*j]]/pivot;
+
+    // it must be a product
+    for(int i=0;i<nq_x_;i++)
+      for(int j=0;j<nq_y_;j++)
+        if(std::fabs(M[point_[i+nq_x_*j]]-u[i]*v[j])>1.0e-10*std::fabs(pivot))
+          return;
+
+    scale_[b] = normalize(u)*normalize(v);
+    a_[b] = findOrAddFactor(X_,u);
+    c_[b] = findOrAddFactor(Y_,v);
+  }
+  nb_x_ = X_.size()/nq_x_;
+  nb_y_ = Y_.size()/nq_y_;
+  if(nb_x_*nb_y_!=num_basis)
+    return;
+
+  basis_.assign(num_basis,-1);
+  for(int b=0;b<num_basis;b++)
+    basis_[a_[b]+nb_x_*c_[b]] = b;
+  if(std::find(basis_.begin(),basis_.end(),-1)!=basis_.end())
+    return;
+
+  // derivatives of the factors: d/dxi phi_b = s_b X_a' Y_c, evaluated where Y_c is largest
+  dX_.assign(X_.size(),0.0);
+  dY_.assign(Y_.size(),0.0);
+  for(int a=0;a<nb_x_;a++) {
+    const int b = basis_[a];
+    const int c = c_[b];
+    int j_max = 0;
+    for(int j=0;j<nq_y_;j++)
+      if(std::fabs(Y_[c*nq_y_+j])>std::fabs(Y_[c*nq_y_+j_max]))
+        j_max = j;
+    for(int i=0;i<nq_x_;i++)
+      dX_[a*nq_x_+i] = ref_grads[2*(b*num_points+point_[i+nq_x_*j_max])+0]/(scale_[b]*Y_[c*nq_y_+j_max]);
+  }
+  for(int c=0;c<nb_y_;c++) {
+    const int b = basis_[nb_x_*c];
+    const int a = a_[b];
+    int i_max = 0;
+    for(int i=0;i<nq_x_;i++)
+      if(std::fabs(X_[a*nq_x_+i])>std::fabs(X_[a*nq_x_+i_max]))
+        i_max = i;
+    for(int j=0;j<nq_y_;j++)
+      dY_[c*nq_y_+j] = ref_grads[2*(b*num_points+point_[i_max+nq_x_*j])+1]/(scale_[b]*X_[a*nq_x_+i_max]);
+  }
+
+  valid_ = true;
+}
+
+}
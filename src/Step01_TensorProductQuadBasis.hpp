@@ -0,0 +1,165 @@
+#ifndef __Step01_TensorProductQuadBasis_hpp__
+#define __Step01_TensorProductQuadBasis_hpp__
+
+#include <vector>
+
+namespace user_app {
+
+/** One dimensional factors of a tensor-product basis on a tensor-product
+  * quadrilateral cubature, for sum-factorized assembly.
+  *
+  * The factors are recovered from the reference values and gradients of the
+  * basis at the reference cubature points, so no assumption is made about how
+  * Intrepid orders the basis functions or the points: every basis function
+  * \f$\phi_b(\xi,\eta) = s_b X_{a(b)}(\xi) Y_{c(b)}(\eta)\f$ is split into
+  * normalized 1D factors, tabulated (with their derivatives) at the 1D points.
+  *
+  * With \f$p+1\f$ functions and \f$q\f$ points per direction, interpolating to
+  * all points and integrating against all basis functions costs
+  * \f$O(p\,q^2 + p^2 q)\f$ per cell instead of \f$O(p^2 q^2)\f$.
+  */
+class TensorProductQuadBasis {
+public:
+
+  /** \param[in] ref_points Reference points, <code>ref_points[2*q+d]</code>
+    * \param[in] ref_values Reference basis values, <code>ref_values[b*num_points+q]</code>
+    * \param[in] ref_grads Reference basis gradients, <code>ref_grads[2*(b*num_points+q)+d]</code>
+    */
+  TensorProductQuadBasis(int num_basis,int num_points,
+                         const std::vector<double> & ref_points,
+                         const std::vector<double> & ref_values,
+                         const std::vector<double> & ref_grads);
+
+  //! Did the basis and the cubature factor into tensor products?
+  bool isTensorProduct() const
+  { return valid_; }
+
+  int numBasis() const { return num_basis_; }
+  int numPoints() const { return num_points_; }
+
+  //! Scratch entries the kernels below need
+  int scratchSize() const
+  { return 2*nb_y_*nq_x_; }
+
+  /** Values and reference gradients at the cubature points (in the ordering of
+    * the cubature) of \f$\sum_b coeff_b \phi_b\f$.
+    *
+    * \param[in] coeff Coefficient of every basis function
+    * \param[out] value,grad_xi,grad_eta Per cubature point, may be null
+    */
+  template <typename ScalarT,typename CoeffFunc>
+  void interpolate(const CoeffFunc & coeff,
+                   ScalarT * value,ScalarT * grad_xi,ScalarT * grad_eta,
+                   std::vector<ScalarT> & scratch) const;
+
+  /** \f$R_b = \sum_q s_q \phi_b + f^\xi_q \partial_\xi\phi_b + f^\eta_q \partial_\eta\phi_b\f$
+    * over the cubature points (in the ordering of the cubature).
+    *
+    * \param[in] s,flux_xi,flux_eta Per cubature point, weights included
+    * \param[out] residual Called as <code>residual(b,value)</code>
+    */
+  template <typename ScalarT,typename ResidualFunc>
+  void integrate(const ScalarT * s,const ScalarT * flux_xi,const ScalarT * flux_eta,
+                 const ResidualFunc & residual,
+                 std::vector<ScalarT> & scratch) const;
+
+private:
+
+  bool valid_;
+  int num_basis_, num_points_;
+
+  // 1D points in each direction, and the cubature point of each (i,j) pair
+  int nq_x_, nq_y_;
+  std::vector<int> point_;     // point_[i+nq_x_*j]
+
+  // 1D factors, X_[a*nq_x_+i] = X_a(xi_i) and so on
+  int nb_x_, nb_y_;
+  std::vector<double> X_, dX_, Y_, dY_;
+
+  // basis function b is scale_[b] X_{a_[b]} Y_{c_[b]}
+  std::vector<int> a_, c_;
+  std::vector<double> scale_;
+  // and the other way around, the basis function of each (a,c) pair
+  std::vector<int> basis_;     // basis_[a+nb_x_*c]
+};
+
+//**********************************************************************
+template <typename ScalarT,typename CoeffFunc>
+void TensorProductQuadBasis::
+interpolate(const CoeffFunc & coeff,
+            ScalarT * value,ScalarT * grad_xi,ScalarT * grad_eta,
+            std::vector<ScalarT> & scratch) const
+{
+  // contract xi first: T0(c,i) = sum_a X_a(xi_i) C(a,c), T1 the same with X_a'
+  ScalarT * T0 = &scratch[0];
+  ScalarT * T1 = &scratch[nb_y_*nq_x_];
+  for(int c=0;c<nb_y_;c++) {
+    for(int i=0;i<nq_x_;i++) {
+      T0[c*nq_x_+i] = 0.0;
+      T1[c*nq_x_+i] = 0.0;
+    }
+    for(int a=0;a<nb_x_;a++) {
+      const int b = basis_[a+nb_x_*c];
+      const ScalarT C = scale_[b]*coeff(b);
+      for(int i=0;i<nq_x_;i++) {
+        T0[c*nq_x_+i] += X_[a*nq_x_+i]*C;
+        T1[c*nq_x_+i] += dX_[a*nq_x_+i]*C;
+      }
+    }
+  }
+
+  // then eta
+  for(int j=0;j<nq_y_;j++) {
+    for(int i=0;i<nq_x_;i++) {
+      const int q = point_[i+nq_x_*j];
+      if(value!=0)    value[q] = 0.0;
+      if(grad_xi!=0)  grad_xi[q] = 0.0;
+      if(grad_eta!=0) grad_eta[q] = 0.0;
+      for(int c=0;c<nb_y_;c++) {
+        if(value!=0)    value[q]    += Y_[c*nq_y_+j]*T0[c*nq_x_+i];
+        if(grad_xi!=0)  grad_xi[q]  += Y_[c*nq_y_+j]*T1[c*nq_x_+i];
+        if(grad_eta!=0) grad_eta[q] += dY_[c*nq_y_+j]*T0[c*nq_x_+i];
+      }
+    }
+  }
+}
+
+//**********************************************************************
+template <typename ScalarT,typename ResidualFunc>
+void TensorProductQuadBasis::
+integrate(const ScalarT * s,const ScalarT * flux_xi,const ScalarT * flux_eta,
+          const ResidualFunc & residual,
+          std::vector<ScalarT> & scratch) const
+{
+  // contract eta first: W0(c,i) = sum_j Y_c s + Y_c' f^eta, W1(c,i) = sum_j Y_c f^xi
+  ScalarT * W0 = &scratch[0];
+  ScalarT * W1 = &scratch[nb_y_*nq_x_];
+  for(int c=0;c<nb_y_;c++) {
+    for(int i=0;i<nq_x_;i++) {
+      ScalarT & w0 = W0[c*nq_x_+i];
+      ScalarT & w1 = W1[c*nq_x_+i];
+      w0 = 0.0;
+      w1 = 0.0;
+      for(int j=0;j<nq_y_;j++) {
+        const int q = point_[i+nq_x_*j];
+        w0 += Y_[c*nq_y_+j]*s[q] + dY_[c*nq_y_+j]*flux_eta[q];
+        w1 += Y_[c*nq_y_+j]*flux_xi[q];
+      }
+    }
+  }
+
+  // then xi
+  for(int c=0;c<nb_y_;c++) {
+    for(int a=0;a<nb_x_;a++) {
+      const int b = basis_[a+nb_x_*c];
+      ScalarT r = 0.0;
+      for(int i=0;i<nq_x_;i++)
+        r += X_[a*nq_x_+i]*W0[c*nq_x_+i] + dX_[a*nq_x_+i]*W1[c*nq_x_+i];
+      residual(b,scale_[b]*r);
+    }
+  }
+}
+
+}
+
+#endif
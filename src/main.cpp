@@ -48,6 +48,7 @@
 #include "Teuchos_GlobalMPISession.hpp"
 #include "Teuchos_CommandLineProcessor.hpp"
 #include "Teuchos_XMLParameterListHelpers.hpp"
+#include "Teuchos_StandardParameterEntryValidators.hpp"
 #include "Teuchos_FancyOStream.hpp"
 #include "Teuchos_oblackholestream.hpp"
 #include "Teuchos_Assert.hpp"
@@ -67,6 +68,7 @@
 #include "Panzer_ElementBlockIdToPhysicsIdMap.hpp"
 #include "Panzer_DOFManagerFactory.hpp"
 #include "Panzer_ModelEvaluator.hpp"
+#include "Panzer_FieldManagerBuilder.hpp"
 
 #include "Panzer_STK_SquareQuadMeshFactory.hpp"
 #include "Panzer_STK_SetupLOWSFactory.hpp"
@@ -77,12 +79,39 @@
 
 #include "NOX_Thyra.H"
 
+#include "Teko_RequestHandler.hpp"
+
+#include "Thyra_EpetraThyraWrappers.hpp"
+#include "Thyra_EpetraLinearOp.hpp"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Vector.h"
+#include "Thyra_DefaultProductVector.hpp"
+#include "Thyra_LinearOpWithSolveFactoryHelpers.hpp"
+#include "Thyra_PreconditionerFactoryHelpers.hpp"
+
 #include "Step01_ClosureModel_Factory_TemplateBuilder.hpp"
 #include "Step01_EquationSetFactory.hpp"
 #include "Step01_BCStrategy_Factory.hpp"
+#include "Step01_HarmonicBlockSolver.hpp"
+#include "Step01_HarmonicKroneckerOp.hpp"
+#include "Step01_FieldTransfer.hpp"
+#include "Step01_HarmonicIndexSet.hpp"
+#include "Step01_HarmonicBalanceConfig.hpp"
+#include "Step01_ComplexHarmonicSolver.hpp"
+#include "Step01_HarmonicMeanPreconditioner.hpp"
+#include "Step01_FiniteDifferenceJacobianOp.hpp"
+#include "Step01_ClosureConstants.hpp"
+#include "Step01_EvaluationTypes.hpp"
+#include "Step01_BDFIntegrator.hpp"
+#include "Step01_PIDStepController.hpp"
+#include "Step01_Parareal.hpp"
+#include "Step01_KrylovExponentialIntegrator.hpp"
 
 #include <Ioss_SerializeIO.h>
 
+#include <algorithm>
+#include <cmath>
+#include <set>
 #include <string>
 #include <iostream>
 
@@ -92,6 +121,7 @@ buildSTKIOResponseLibrary(const std::vector<Teuchos::RCP<panzer::PhysicsBlock> >
                           const Teuchos::RCP<panzer::WorksetContainer> & wkstContainer,
                           const Teuchos::RCP<panzer::UniqueGlobalIndexerBase> & globalIndexer,
                           const panzer::ClosureModelFactory_TemplateManager<panzer::Traits> & cm_factory,
+                          const user_app::EvaluationTypes & eval_types,
                           const Teuchos::RCP<panzer_stk::STK_Interface> & mesh,
                           const Teuchos::ParameterList & closure_model_pl,
                           const Teuchos::ParameterList & user_data);
@@ -101,6 +131,121 @@ void writeToExodus(const Teuchos::RCP<const Thyra::VectorBase<double> > & x,
                    panzer::ResponseLibrary<panzer::Traits> & stkIOResponseLibrary,
                    panzer_stk::STK_Interface & mesh);
 
+// the pieces of an assembled physics model that the driver holds on to
+struct PhysicsModel {
+  Teuchos::RCP<panzer::UniqueGlobalIndexer<int,int> > dofManager;
+  Teuchos::RCP<panzer::LinearObjFactory<panzer::Traits> > linObjFactory;
+  Teuchos::RCP<panzer::WorksetContainer> wkstContainer;
+  Teuchos::RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory;
+  Teuchos::RCP<panzer::ModelEvaluator<double> > physics;
+};
+
+void buildPhysicsModel(const std::vector<Teuchos::RCP<panzer::PhysicsBlock> > & physicsBlocks,
+                       const Teuchos::RCP<panzer_stk::STK_Interface> & mesh,
+                       const Teuchos::RCP<panzer::ConnManager<int,int> > & conn_manager,
+                       const Teuchos::RCP<const Teuchos::MpiComm<int> > & comm,
+                       const Teuchos::RCP<Teuchos::ParameterList> & lin_solver_pl,
+                       int workset_size,
+                       const Teuchos::RCP<panzer::GlobalData> & globalData,
+                       bool build_transient_support,
+                       const std::vector<panzer::BC> & bcs,
+                       const panzer::EquationSetFactory & eqset_factory,
+                       const panzer::BCStrategyFactory & bc_factory,
+                       const panzer::ClosureModelFactory_TemplateManager<panzer::Traits> & cm_factory,
+                       const user_app::EvaluationTypes & eval_types,
+                       const Teuchos::ParameterList & closure_models_pl,
+                       const Teuchos::ParameterList & user_data_pl,
+                       PhysicsModel & model);
+
+// copy of the physics blocks with every "FreqDom" equation set replaced by its time domain equation set
+Teuchos::RCP<Teuchos::ParameterList>
+buildTimeDomainPhysicsBlocks(const Teuchos::ParameterList & physics_blocks_pl);
+
+// the (first) "FreqDom" equation set of the physics blocks
+const Teuchos::ParameterList & findFreqDomEquationSet(const Teuchos::ParameterList & physics_blocks_pl);
+
+// the parsed options of the (first) "FreqDom" equation set, as the equation set factory sees them
+Teuchos::RCP<const user_app::HarmonicBalanceConfig>
+buildHarmonicBalanceConfig(const Teuchos::ParameterList & physics_blocks_pl);
+
+// whether any equation set of the physics blocks has a nonzero "Nonlinear reaction coefficient"
+bool hasNonlinearReaction(const Teuchos::ParameterList & physics_blocks_pl);
+
+// set the "Truncation order" of every "FreqDom" equation set
+void setTruncationOrder(Teuchos::ParameterList & physics_blocks_pl,int order);
+
+// fraction of the time averaged energy of the FreqDom solution held by the harmonics
+// that the truncation order adds over the next lower order, with the energy of a field
+// weighted by the mass matrix of the time domain model
+double outerHarmonicEnergyFraction(const Teuchos::ParameterList & physics_blocks_pl,
+                                   const PhysicsModel & model,
+                                   const Teuchos::RCP<const Thyra::VectorBase<double> > & solution_vec,
+                                   const PhysicsModel & td_model,
+                                   const Thyra::LinearOpBase<double> & mass);
+
+// copy the fields the two models share from src to dst
+void copyCommonFields(const PhysicsModel & src_model,
+                      const Teuchos::RCP<const Thyra::VectorBase<double> > & src,
+                      const PhysicsModel & dst_model,
+                      const Teuchos::RCP<Thyra::VectorBase<double> > & dst);
+
+// the harmonic balance DOF names (0th mode first) and the harmonic differentiation matrix
+// D, so that d/dt of the harmonic coefficients is D times the coefficients
+void buildHarmonicCoupling(const Teuchos::ParameterList & physics_blocks_pl,
+                           std::string & td_dof_name,
+                           std::vector<std::string> & hb_dof_names,
+                           Teuchos::SerialDenseMatrix<int,double> & coupling);
+
+// assemble F(0) and the mass and stiffness matrices of a transient model
+void assembleMassAndStiffness(const panzer::ModelEvaluator<double> & td_physics,
+                              Teuchos::RCP<Thyra::VectorBase<double> > & f0,
+                              Teuchos::RCP<Thyra::LinearOpBase<double> > & mass,
+                              Teuchos::RCP<Thyra::LinearOpBase<double> > & stiffness);
+
+// solve the harmonic balance system with the implicit Kronecker product operator
+void solveKronecker(const PhysicsModel & td_model,
+                    const std::string & td_dof_name,
+                    const PhysicsModel & hb_model,
+                    const std::vector<std::string> & hb_dof_names,
+                    const Teuchos::SerialDenseMatrix<int,double> & coupling,
+                    const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec);
+
+// solve the harmonic balance equations of a linear problem one complex harmonic at a time from
+// the mass and stiffness matrices of the time domain model alone; the 0th mode goes to
+// solution_vec, the cosine/sine coefficients straight to their fields on the mesh
+void solveComplexHarmonics(const PhysicsModel & td_model,
+                           const user_app::HarmonicBalanceConfig & hb_config,
+                           const Teuchos::RCP<const Teuchos::Comm<int> > & comm,
+                           const Teuchos::ParameterList & complex_solver_pl,
+                           const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec,
+                           panzer_stk::STK_Interface & mesh);
+
+// integrate the time domain model with backward Euler and project the last period
+// onto the harmonics, giving an initial guess for the harmonic balance solve
+void transientInitialGuess(const PhysicsModel & td_model,
+                           const std::string & td_dof_name,
+                           const PhysicsModel & hb_model,
+                           const std::vector<std::string> & hb_dof_names,
+                           const Teuchos::SerialDenseMatrix<int,double> & coupling,
+                           const Teuchos::ParameterList & transient_pl,
+                           const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec);
+
+// integrate a transient model with BDF time stepping, with a fixed or an error controlled
+// step, or with Parareal across the ranks of time_comm if it is not null; solution_vec
+// holds the initial condition on entry and the solution at the end of this rank's time
+// slice (the final solution without Parareal) on exit
+void integrateTransient(const PhysicsModel & model,
+                        const Teuchos::ParameterList & transient_pl,
+                        const Teuchos::RCP<const Teuchos::Comm<int> > & time_comm,
+                        const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec);
+
+// advance the integrator to final_time with the fixed or adaptive steps of the "Transient"
+// sublist, returns the number of rejected steps
+int advanceTransient(user_app::BDFIntegrator & integrator,
+                     const Teuchos::ParameterList & transient_pl,
+                     double final_time,
+                     bool verbose);
+
 int main(int argc, char *argv[])
 {
   typedef panzer::ModelEvaluator<double> PME;
@@ -158,23 +303,139 @@ int main(int argc, char *argv[])
     Teuchos::ParameterList & bcs_pl                 = input_params->sublist("Boundary Conditions");
     Teuchos::ParameterList & closure_models_pl      = input_params->sublist("Closure Models");
     Teuchos::ParameterList & user_data_pl           = input_params->sublist("User Data");
+    Teuchos::ParameterList & solution_control_pl    = input_params->sublist("Solution Control");
+
+    // "Monolithic" solves the whole system at once, "Harmonic Blocks" splits a
+    // harmonic balance system into its decoupled blocks and solves those separately,
+    // "Kronecker" never assembles the harmonic balance matrix and applies it from
+    // the mass and stiffness matrices of the time domain equation set instead,
+    // "Complex" solves (K + i omega M) c = r for one complex coefficient per harmonic from
+    // the time domain model alone (Panzer only assembles real scalars, so the complex
+    // operator is formed from the real K and M),
+    // "Finite Difference Matrix Free" hands Belos a one sided finite difference of the residual in
+    // place of the Jacobian, which is only accurate to about sqrt(machine epsilon) relative to J v
+    const std::string linear_solve_mode = solution_control_pl.get<std::string>("Linear Solve Mode","Monolithic");
+    const std::string block_concurrency = solution_control_pl.get<std::string>("Harmonic Block Concurrency","Serial");
+    TEUCHOS_TEST_FOR_EXCEPTION(linear_solve_mode!="Monolithic" && linear_solve_mode!="Harmonic Blocks" &&
+                               linear_solve_mode!="Kronecker" && linear_solve_mode!="Complex" &&
+                               linear_solve_mode!="Finite Difference Matrix Free",
+                               std::runtime_error,
+                               "Unknown \"Linear Solve Mode\" = \"" << linear_solve_mode << "\", choose \"Monolithic\", "
+                               "\"Harmonic Blocks\", \"Kronecker\", \"Complex\" or \"Finite Difference Matrix Free\".");
+    // the implicit operator has no matrix, so only an unpreconditioned Krylov method can take it
+    TEUCHOS_TEST_FOR_EXCEPTION(linear_solve_mode=="Kronecker" &&
+                               (lin_solver_pl->get<std::string>("Linear Solver Type")!="Belos" ||
+                                lin_solver_pl->get<std::string>("Preconditioner Type")!="None"),
+                               std::runtime_error,
+                               "\"Linear Solve Mode\" = \"Kronecker\" requires \"Linear Solver Type\" = \"Belos\" "
+                               "and \"Preconditioner Type\" = \"None\".");
+    // the finite difference operator needs a Krylov method; a "Preconditioner Type" other than "None"
+    // is built from a Jacobian matrix assembled every "Matrix Free Preconditioner Lag" Newton iterations
+    TEUCHOS_TEST_FOR_EXCEPTION(linear_solve_mode=="Finite Difference Matrix Free" &&
+                               lin_solver_pl->get<std::string>("Linear Solver Type")!="Belos",
+                               std::runtime_error,
+                               "\"Linear Solve Mode\" = \"Finite Difference Matrix Free\" requires \"Linear Solver Type\" = \"Belos\".");
+    const int matrix_free_prec_lag = solution_control_pl.get<int>("Matrix Free Preconditioner Lag",1);
+    TEUCHOS_TEST_FOR_EXCEPTION(matrix_free_prec_lag<1,std::runtime_error,
+                               "\"Matrix Free Preconditioner Lag\" must be at least 1.");
+    // both are built from the mass and stiffness matrices, so only represent linear problems
+    TEUCHOS_TEST_FOR_EXCEPTION((linear_solve_mode=="Kronecker" || linear_solve_mode=="Complex") &&
+                               buildHarmonicBalanceConfig(*physics_blocks_pl)->nonlinearCoefficient()!=0.0,
+                               std::runtime_error,
+                               "\"Linear Solve Mode\" = \"" << linear_solve_mode << "\" only represents linear problems!");
+    // Newton iterations for the Monolithic and Harmonic Blocks modes (nonlinear harmonic balance)
+    const int newton_max_iterations = solution_control_pl.get<int>("Newton Max Iterations",1);
+    const double newton_tolerance   = solution_control_pl.get<double>("Newton Tolerance",1.0e-10);
+    TEUCHOS_TEST_FOR_EXCEPTION(block_concurrency!="Serial" && block_concurrency!="Sub-Communicators",std::runtime_error,
+                               "Unknown \"Harmonic Block Concurrency\" = \"" << block_concurrency << "\", choose \"Serial\" or \"Sub-Communicators\".");
+    // adaptive truncation: start at a low "Truncation order" and raise it while the highest
+    // harmonics hold more than the tolerance of the energy, up to the order in the input
+    const bool adaptive_truncation  = solution_control_pl.get<bool>("Adaptive Truncation",false);
+    const int adaptive_initial_order = solution_control_pl.get<int>("Adaptive Initial Order",1);
+    const double adaptive_tolerance  = solution_control_pl.get<double>("Adaptive Energy Tolerance",1.0e-6);
+    const int max_truncation_order = adaptive_truncation
+        ? buildHarmonicBalanceConfig(*physics_blocks_pl)->truncationOrder() : 0;
+    // "Zero" starts from u = 0, "Transient" integrates the time domain equation set over a few
+    // periods and projects the last one onto the harmonics
+    const std::string initial_guess = solution_control_pl.get<std::string>("Initial Guess","Zero");
+    TEUCHOS_TEST_FOR_EXCEPTION(initial_guess!="Zero" && initial_guess!="Transient",std::runtime_error,
+                               "Unknown \"Initial Guess\" = \"" << initial_guess << "\", choose \"Zero\" or \"Transient\".");
+
+    // "Steady" solves for the steady (or harmonic balance) solution, "Transient" integrates the
+    // time domain equation sets, u_t - lap u + u = f, in time from the "Transient" sublist
+    const std::string analysis = solution_control_pl.get<std::string>("Analysis","Steady");
+    TEUCHOS_TEST_FOR_EXCEPTION(analysis!="Steady" && analysis!="Transient",std::runtime_error,
+                               "Unknown \"Analysis\" = \"" << analysis << "\", choose \"Steady\" or \"Transient\".");
+    TEUCHOS_TEST_FOR_EXCEPTION(analysis=="Transient" && (linear_solve_mode!="Monolithic" || adaptive_truncation),
+                               std::runtime_error,
+                               "\"Analysis\" = \"Transient\" requires \"Linear Solve Mode\" = \"Monolithic\" "
+                               "and no \"Adaptive Truncation\".");
+    // the complex mode solves every harmonic directly, there is no harmonic balance model
+    // to adapt or to start from a guess
+    TEUCHOS_TEST_FOR_EXCEPTION(linear_solve_mode=="Complex" && (adaptive_truncation || initial_guess!="Zero"),
+                               std::runtime_error,
+                               "\"Linear Solve Mode\" = \"Complex\" requires no \"Adaptive Truncation\" "
+                               "and \"Initial Guess\" = \"Zero\".");
+    // the transient problem is posed on the time domain equation sets of any FreqDom ones
+    if(analysis=="Transient")
+      physics_blocks_pl = buildTimeDomainPhysicsBlocks(*physics_blocks_pl);
+    // so is the complex mode, which never builds the harmonic balance model: it solves the
+    // harmonics from the mass and stiffness matrices of the time domain equation sets
+    RCP<const user_app::HarmonicBalanceConfig> complex_hb_config;
+    if(linear_solve_mode=="Complex") {
+      complex_hb_config = buildHarmonicBalanceConfig(*physics_blocks_pl);
+      physics_blocks_pl = buildTimeDomainPhysicsBlocks(*physics_blocks_pl);
+    }
+    // the exponential integrator is exact for the linear heat equation, and only takes that
+    TEUCHOS_TEST_FOR_EXCEPTION(analysis=="Transient" &&
+                               solution_control_pl.sublist("Transient").get<std::string>("Scheme","BDF2")=="Exponential" &&
+                               hasNonlinearReaction(*physics_blocks_pl),
+                               std::runtime_error,
+                               "The transient \"Scheme\" = \"Exponential\" only integrates linear problems!");
+
+    // Parareal splits the ranks into groups that each hold the whole mesh and integrate one
+    // time slice; the ranks with the same spatial rank in every group form a time communicator
+    RCP<const Teuchos::Comm<int> > time_comm;
+    const int time_groups = (analysis=="Transient") ? solution_control_pl.sublist("Transient").get<int>("Parareal Time Groups",1) : 1;
+    TEUCHOS_TEST_FOR_EXCEPTION(time_groups<1 || comm->getSize()%time_groups!=0,std::runtime_error,
+                               "\"Parareal Time Groups\" = " << time_groups << " must divide the " << comm->getSize() << " ranks!");
+    if(time_groups>1) {
+      const int space_size = comm->getSize()/time_groups;
+      const int time_group = comm->getRank()/space_size;
+      time_comm = comm->split(comm->getRank()%space_size,time_group);
+      comm = rcp_dynamic_cast<const Teuchos::MpiComm<int> >(comm->split(time_group,comm->getRank()),true);
+      *out << "Parareal: " << time_groups << " time slices of " << space_size << " rank(s) each" << std::endl;
+    }
 
     user_data_pl.set<RCP<const Teuchos::Comm<int> > >("Comm", comm);
+    // the equation sets fold constant closure fields into their evaluators as numbers
+    user_app::addClosureConstants(closure_models_pl,user_data_pl);
 
     RCP<panzer::GlobalData> globalData = panzer::createGlobalData();
-    RCP<user_app::EquationSetFactory> eqset_factory = Teuchos::rcp(new user_app::EquationSetFactory);
+    // only the residual and the Jacobian are ever evaluated here, equation sets and
+    // closure models of any other evaluation type would be built for nothing
+    Teuchos::Array<std::string> default_eval_types;
+    default_eval_types.push_back("Residual");
+    default_eval_types.push_back("Jacobian");
+    const user_app::EvaluationTypes eval_types(solution_control_pl.get<Teuchos::Array<std::string> >("Evaluation Types",default_eval_types));
+
+    RCP<user_app::EquationSetFactory> eqset_factory = Teuchos::rcp(new user_app::EquationSetFactory(eval_types));
     user_app::BCStrategyFactory bc_factory; 
 
     user_app::ClosureModelFactory_TemplateBuilder cm_builder;
     panzer::ClosureModelFactory_TemplateManager<panzer::Traits> cm_factory;  
+    eval_types.disableInactive(cm_factory);
     cm_factory.buildObjects(cm_builder);
 
+    // make "Harmonic Mean Block Diagonal" available to Teko in the "Linear Solver" list
+    user_app::HarmonicMeanPreconditionerFactory::registerFactory();
+
     // read in mesh database, build un committed data
     ////////////////////////////////////////////////////////////////
     RCP<panzer_stk::STK_MeshFactory> mesh_factory = rcp(new panzer_stk::SquareQuadMeshFactory);
     mesh_factory->setParameterList(mesh_pl);
 
-    RCP<panzer_stk::STK_Interface> mesh = mesh_factory->buildUncommitedMesh(MPI_COMM_WORLD);
+    RCP<panzer_stk::STK_Interface> mesh = mesh_factory->buildUncommitedMesh(*comm->getRawMpiComm());
 
     // read in physics blocks
     ////////////////////////////////////////////////////////////
@@ -191,7 +452,7 @@ int main(int argc, char *argv[])
     // setup some defaults
     int workset_size = 20;
     int default_integration_order = 2;
-    bool build_transient_support = false;
+    bool build_transient_support = (analysis=="Transient" || linear_solve_mode=="Complex");
     std::vector<std::string> tangentParamNames;
 
     panzer::buildPhysicsBlocks(block_ids_to_physics_ids,
@@ -233,7 +494,14 @@ int main(int argc, char *argv[])
          }
       }
 
-      mesh_factory->completeMeshConstruction(*mesh,MPI_COMM_WORLD);
+      // the harmonics of the complex mode are no DOFs, it writes them to the mesh itself
+      if(complex_hb_config!=Teuchos::null) {
+        const std::vector<std::string> & harmonic_dof_names = complex_hb_config->harmonicDOFNames();
+        for(std::size_t f=0;f<harmonic_dof_names.size();f++)
+          mesh->addSolutionField(harmonic_dof_names[f],pb->elementBlockID());
+      }
+
+      mesh_factory->completeMeshConstruction(*mesh,*comm->getRawMpiComm());
     }
 
     // build DOF Manager
@@ -243,96 +511,258 @@ int main(int argc, char *argv[])
     const Teuchos::RCP<panzer::ConnManager<int,int> > 
       conn_manager = Teuchos::rcp(new panzer_stk::STKConnManager<int>(mesh));
 
-    // build the state dof manager and LOF
-    RCP<panzer::UniqueGlobalIndexer<int,int> > dofManager;
-    RCP<panzer::LinearObjFactory<panzer::Traits> > linObjFactory;
-    {
-      panzer::DOFManagerFactory<int,int> globalIndexerFactory;
-      dofManager = globalIndexerFactory.buildUniqueGlobalIndexer(Teuchos::opaqueWrapper(MPI_COMM_WORLD),physicsBlocks,conn_manager);
-      linObjFactory = Teuchos::rcp(new panzer::EpetraLinearObjFactory<panzer::Traits,int>(comm,dofManager));
+    std::vector<panzer::BC> bcs;
+    panzer::buildBCs(bcs,bcs_pl,globalData);
+
+    // adaptive truncation raises the truncation order one step at a time, the mesh
+    // already holds the fields of the largest order
+    int truncation_order = adaptive_truncation ? std::min(adaptive_initial_order,max_truncation_order) : max_truncation_order;
+
+    // the energy of the harmonics is weighted by the mass matrix of the time domain equation
+    // set, which does not depend on the truncation order
+    PhysicsModel energy_model;
+    RCP<Thyra::LinearOpBase<double> > energy_mass;
+    if(adaptive_truncation) {
+      std::vector<RCP<panzer::PhysicsBlock> > td_physicsBlocks;
+      panzer::buildPhysicsBlocks(block_ids_to_physics_ids,
+                                 block_ids_to_cell_topo,
+                                 buildTimeDomainPhysicsBlocks(*physics_blocks_pl),
+                                 default_integration_order,
+                                 workset_size,
+                                 eqset_factory,
+                                 globalData,
+                                 true,
+                                 td_physicsBlocks,
+                                 tangentParamNames);
+
+      buildPhysicsModel(td_physicsBlocks,mesh,conn_manager,comm,lin_solver_pl,workset_size,globalData,
+                        true,bcs,*eqset_factory,bc_factory,cm_factory,eval_types,
+                        closure_models_pl,user_data_pl,energy_model);
+
+      RCP<Thyra::VectorBase<double> > f0;
+      RCP<Thyra::LinearOpBase<double> > stiffness;
+      assembleMassAndStiffness(*energy_model.physics,f0,energy_mass,stiffness);
     }
 
-    // build worksets
-    //////////////////////////////////////////////////////////////
-    
-    // build WorksetContainer
-    Teuchos::RCP<panzer_stk::WorksetFactory> wkstFactory 
-       = Teuchos::rcp(new panzer_stk::WorksetFactory(mesh)); // build STK workset factory
-    Teuchos::RCP<panzer::WorksetContainer> wkstContainer             // attach it to a workset container (uses lazy evaluation)
-       = Teuchos::rcp(new panzer::WorksetContainer(wkstFactory,physicsBlocks,workset_size));
-    wkstContainer->setGlobalIndexer(dofManager);
-    std::cout << "In main(), built the workset container." << std::endl;
-
-    // build linear solver 
-    /////////////////////////////////////////////////////////////
-    
-    RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory
-        = panzer_stk::buildLOWSFactory(false, dofManager, conn_manager, 
-                                               Teuchos::as<int>(mesh->getDimension()), 
-                                               comm, lin_solver_pl,Teuchos::null);
-    std::cout << "In main(), built the linear solver." << std::endl;
+    PhysicsModel model, previous_model;
+    RCP<Thyra::VectorBase<double> > solution_vec, previous_solution;
+    for(;;truncation_order++) {
+
+      RCP<Teuchos::ParameterList> order_physics_blocks_pl = physics_blocks_pl;
+      if(adaptive_truncation) {
+        order_physics_blocks_pl = rcp(new Teuchos::ParameterList(*physics_blocks_pl));
+        setTruncationOrder(*order_physics_blocks_pl,truncation_order);
+
+        physicsBlocks.clear();
+        panzer::buildPhysicsBlocks(block_ids_to_physics_ids,
+                                   block_ids_to_cell_topo,
+                                   order_physics_blocks_pl,
+                                   default_integration_order,
+                                   workset_size,
+                                   eqset_factory,
+                                   globalData,
+                                   build_transient_support,
+                                   physicsBlocks,
+                                   tangentParamNames);
+        *out << "Adaptive truncation: solving with \"Truncation order\" = " << truncation_order << std::endl;
+      }
 
-    // build and setup model evaluatorlinear solver 
-    /////////////////////////////////////////////////////////////
-    
-    std::vector<panzer::BC> bcs;
-    panzer::buildBCs(bcs,bcs_pl,globalData);
+      // build the DOF manager, worksets, linear solver and model evaluator
+      buildPhysicsModel(physicsBlocks,mesh,conn_manager,comm,lin_solver_pl,workset_size,globalData,
+                        build_transient_support,bcs,*eqset_factory,bc_factory,cm_factory,eval_types,
+                        closure_models_pl,user_data_pl,model);
 
-    RCP<PME> physics = Teuchos::rcp(new PME(linObjFactory,lowsFactory,globalData,build_transient_support,0.0));
-    physics->setupModel(wkstContainer,physicsBlocks,bcs,
-                   *eqset_factory,
-                   bc_factory,
-                   cm_factory,
-                   cm_factory,
-                   closure_models_pl,
-                   user_data_pl,false,"");
-    std::cout << "In main(), set up and built the model evaluator linear solver." << std::endl;
+      RCP<panzer::UniqueGlobalIndexer<int,int> > dofManager = model.dofManager;
+      RCP<panzer::LinearObjFactory<panzer::Traits> > linObjFactory = model.linObjFactory;
+      RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory = model.lowsFactory;
+      RCP<PME> physics = model.physics;
+      std::cout << "In main(), set up and built the model evaluator linear solver." << std::endl;
 
-    // setup a response library to write to the mesh
-    /////////////////////////////////////////////////////////////
-    
-    RCP<panzer::ResponseLibrary<panzer::Traits> > stkIOResponseLibrary
-        = buildSTKIOResponseLibrary(physicsBlocks,linObjFactory,wkstContainer,dofManager,cm_factory,mesh,
-                                    closure_models_pl,user_data_pl);
-    std::cout << "In main(), set up the response library to write to the mesh." << std::endl;
-  
-    // Allocate vectors and matrix for linear solve
-    /////////////////////////////////////////////////////////////
-    RCP<Thyra::VectorBase<double> > solution_vec = Thyra::createMember(physics->get_x_space());
-    Thyra::assign(solution_vec.ptr(),0.0); // some random initializization
+      if(analysis=="Transient") {
+        solution_vec = Thyra::createMember(physics->get_x_space());
+        Thyra::assign(solution_vec.ptr(),solution_control_pl.sublist("Transient").get<double>("Initial Value",0.0));
 
-    RCP<Thyra::VectorBase<double> > residual = Thyra::createMember(physics->get_f_space());
-    RCP<Thyra::LinearOpWithSolveBase<double> > jacobian = physics->create_W();
-    std::cout << "In main(), allocated the vectors and matrix for the linear solve." << std::endl;
+        integrateTransient(model,solution_control_pl.sublist("Transient"),time_comm,solution_vec);
+        break;
+      }
 
-    // do the assembly, this is where the evaluators are called and the graph is execueted.
-    /////////////////////////////////////////////////////////////
+      if(linear_solve_mode=="Complex") {
+        solution_vec = Thyra::createMember(physics->get_x_space());
 
-    {
-      Thyra::ModelEvaluatorBase::InArgs<double> inArgs = physics->createInArgs();
-      inArgs.set_x(solution_vec);
-      std::cout << "In main(), set the input arguments of the assembly." << std::endl;
+        solveComplexHarmonics(model,*complex_hb_config,comm,solution_control_pl.sublist("Complex Linear Solver"),
+                              solution_vec,*mesh);
+        break;
+      }
 
-      Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = physics->createOutArgs();
-      outArgs.set_f(residual);
-      outArgs.set_W(jacobian);
-      std::cout << "In main(), set the output arguments of the assembly." << std::endl;
+      // Allocate vectors and matrix for linear solve
+      /////////////////////////////////////////////////////////////
+      solution_vec = Thyra::createMember(physics->get_x_space());
+      Thyra::assign(solution_vec.ptr(),0.0); // some random initializization
+
+      // warm start from the previous (lower) truncation order, its harmonics are a subset of these
+      if(previous_solution!=Teuchos::null)
+        copyCommonFields(previous_model,previous_solution,model,solution_vec);
+
+      RCP<Thyra::VectorBase<double> > residual = Thyra::createMember(physics->get_f_space());
+
+      // the block solver builds its own solvers, so only the operator is needed there
+      RCP<Thyra::LinearOpWithSolveBase<double> > jacobian;
+      RCP<Thyra::LinearOpBase<double> > jacobian_op;
+      // in the matrix free mode only the preconditioner, if any, needs a matrix
+      RCP<Thyra::PreconditionerFactoryBase<double> > mf_prec_factory;
+      RCP<user_app::FiniteDifferenceJacobianOp> mf_jacobian;
+      // the blocks follow from the DOF manager and the graph, so they are found once and
+      // only their values are refreshed in later Newton iterations
+      RCP<user_app::HarmonicBlockSolver> block_solver;
+      if(linear_solve_mode=="Harmonic Blocks") {
+        jacobian_op = physics->create_W_op();
+        block_solver = Teuchos::rcp(new user_app::HarmonicBlockSolver(dofManager,lowsFactory,block_concurrency=="Sub-Communicators"));
+      }
+      else if(linear_solve_mode=="Monolithic")
+        jacobian = physics->create_W();
+      else if(linear_solve_mode=="Finite Difference Matrix Free") {
+        mf_jacobian = Teuchos::rcp(new user_app::FiniteDifferenceJacobianOp(physics));
+        mf_prec_factory = lowsFactory->getPreconditionerFactory();
+        if(mf_prec_factory!=Teuchos::null)
+          jacobian_op = physics->create_W_op();
+      }
+      std::cout << "In main(), allocated the vectors and matrix for the linear solve." << std::endl;
+
+      // the time domain model, with transient support, provides the mass and stiffness
+      // matrices of the Kronecker mode and the transient initial guess
+      const bool transient_guess = (initial_guess=="Transient" && previous_solution==Teuchos::null);
+      PhysicsModel td_model;
+      std::string td_dof_name;
+      std::vector<std::string> hb_dof_names;
+      Teuchos::SerialDenseMatrix<int,double> harmonic_coupling;
+      if(linear_solve_mode=="Kronecker" || transient_guess) {
+        RCP<Teuchos::ParameterList> td_physics_blocks_pl = buildTimeDomainPhysicsBlocks(*order_physics_blocks_pl);
+
+        std::vector<RCP<panzer::PhysicsBlock> > td_physicsBlocks;
+        panzer::buildPhysicsBlocks(block_ids_to_physics_ids,
+                                   block_ids_to_cell_topo,
+                                   td_physics_blocks_pl,
+                                   default_integration_order,
+                                   workset_size,
+                                   eqset_factory,
+                                   globalData,
+                                   true,
+                                   td_physicsBlocks,
+                                   tangentParamNames);
+
+        buildPhysicsModel(td_physicsBlocks,mesh,conn_manager,comm,lin_solver_pl,workset_size,globalData,
+                          true,bcs,*eqset_factory,bc_factory,cm_factory,eval_types,
+                          closure_models_pl,user_data_pl,td_model);
+
+        buildHarmonicCoupling(*order_physics_blocks_pl,td_dof_name,hb_dof_names,harmonic_coupling);
+      }
 
-      // construct the residual and jacobian
-      physics->evalModel(inArgs,outArgs);
-      std::cout << "In main(), constructed the residual and Jacobian." << std::endl;
+      if(transient_guess)
+        transientInitialGuess(td_model,td_dof_name,model,hb_dof_names,harmonic_coupling,
+                              solution_control_pl.sublist("Transient Initial Guess"),solution_vec);
 
-    }
+      if(linear_solve_mode=="Kronecker") {
+        solveKronecker(td_model,td_dof_name,model,hb_dof_names,harmonic_coupling,solution_vec);
+        Thyra::scale(-1.0,solution_vec.ptr());
+      }
+      else {
+        // Newton's method, x <- x - J^{-1} f; a linear problem is solved by the first step
+        RCP<Thyra::VectorBase<double> > delta = Thyra::createMember(physics->get_x_space());
+        RCP<Thyra::PreconditionerBase<double> > mf_prec;
+
+        for(int iteration=0;;iteration++) {
+
+          // do the assembly, this is where the evaluators are called and the graph is execueted.
+          /////////////////////////////////////////////////////////////
+
+          {
+            Thyra::ModelEvaluatorBase::InArgs<double> inArgs = physics->createInArgs();
+            inArgs.set_x(solution_vec);
+
+            Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = physics->createOutArgs();
+            outArgs.set_f(residual);
+            if(jacobian!=Teuchos::null)
+              outArgs.set_W(jacobian);
+            else if(linear_solve_mode!="Finite Difference Matrix Free")
+              outArgs.set_W_op(jacobian_op);
+            else if(jacobian_op!=Teuchos::null && iteration%matrix_free_prec_lag==0)
+              outArgs.set_W_op(jacobian_op); // the preconditioner matrix, refreshed
+
+            // construct the residual and jacobian
+            physics->evalModel(inArgs,outArgs);
+            std::cout << "In main(), constructed the residual and Jacobian." << std::endl;
+          }
+
+          const double residual_norm = Thyra::norm_2(*residual);
+          *out << "Newton iteration " << iteration << ": ||f|| = " << residual_norm << std::endl;
+          if(residual_norm<=newton_tolerance || iteration>=newton_max_iterations)
+            break;
+
+          // do a linear solve
+          /////////////////////////////////////////////////////////////
+
+          Thyra::assign(delta.ptr(),0.0);
+          if(linear_solve_mode=="Harmonic Blocks") {
+            RCP<const Epetra_Map> map = rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(linObjFactory,true)->getMap();
+            RCP<const Epetra_CrsMatrix> crs_jacobian = rcp_dynamic_cast<Epetra_CrsMatrix>(Thyra::get_Epetra_Operator(*jacobian_op),true);
+
+            if(block_solver->numBlocks()==0)
+              block_solver->initialize(*crs_jacobian);
+            else
+              block_solver->updateValues(*crs_jacobian);
+
+            RCP<Epetra_Vector> epetra_delta = Thyra::get_Epetra_Vector(*map,delta);
+            RCP<const Epetra_Vector> epetra_f = Thyra::get_Epetra_Vector(*map,residual.getConst());
+            block_solver->solve(*epetra_f,*epetra_delta);
+          }
+          else if(linear_solve_mode=="Finite Difference Matrix Free") {
+            if(jacobian_op!=Teuchos::null && iteration%matrix_free_prec_lag==0)
+              mf_prec = Thyra::prec<double>(*mf_prec_factory,jacobian_op);
+
+            mf_jacobian->setBasePoint(solution_vec,residual);
+            RCP<Thyra::LinearOpWithSolveBase<double> > mf_lows = lowsFactory->createOp();
+            if(mf_prec!=Teuchos::null)
+              Thyra::initializePreconditionedOp<double>(*lowsFactory,mf_jacobian,mf_prec,mf_lows.ptr());
+            else
+              Thyra::initializeOp<double>(*lowsFactory,mf_jacobian,mf_lows.ptr());
+            mf_lows->solve(Thyra::NOTRANS,*residual,delta.ptr());
+            *out << "Finite difference matrix free solve: " << mf_jacobian->numResidualEvaluations() << " residual evaluations so far" << std::endl;
+          }
+          else
+            jacobian->solve(Thyra::NOTRANS,*residual,delta.ptr());
+
+          Thyra::Vp_StV(solution_vec.ptr(),-1.0,*delta);
+        }
+      }
 
-    // do a linear solve
-    /////////////////////////////////////////////////////////////
+      if(!adaptive_truncation || truncation_order>=max_truncation_order)
+        break;
+
+      // stop once the outermost shell of harmonics carries a negligible part of the energy
+      const double energy_fraction = outerHarmonicEnergyFraction(*order_physics_blocks_pl,model,solution_vec,
+                                                                 energy_model,*energy_mass);
+      *out << "Adaptive truncation: order " << truncation_order << " puts a fraction " << energy_fraction
+           << " of the energy in its highest harmonics" << std::endl;
+      if(energy_fraction<=adaptive_tolerance)
+        break;
 
-    jacobian->solve(Thyra::NOTRANS,*residual,solution_vec.ptr());
-    Thyra::scale(-1.0,solution_vec.ptr());
+      previous_model = model;
+      previous_solution = solution_vec;
+    }
 
+    // setup a response library to write to the mesh
+    /////////////////////////////////////////////////////////////
+    
+    RCP<panzer::ResponseLibrary<panzer::Traits> > stkIOResponseLibrary
+        = buildSTKIOResponseLibrary(physicsBlocks,model.linObjFactory,model.wkstContainer,model.dofManager,cm_factory,eval_types,mesh,
+                                    closure_models_pl,user_data_pl);
+    std::cout << "In main(), set up the response library to write to the mesh." << std::endl;
+  
     // write to an exodus file
     /////////////////////////////////////////////////////////////
-    writeToExodus(solution_vec,*physics,*stkIOResponseLibrary,*mesh);
+    // with Parareal the last time slice holds the solution at the final time
+    if(time_comm==Teuchos::null || time_comm->getRank()+1==time_comm->getSize())
+      writeToExodus(solution_vec,*model.physics,*stkIOResponseLibrary,*mesh);
      
   }
   catch (std::exception& e) {
@@ -370,6 +800,7 @@ buildSTKIOResponseLibrary(const std::vector<Teuchos::RCP<panzer::PhysicsBlock> >
                           const Teuchos::RCP<panzer::WorksetContainer> & wkstContainer,
                           const Teuchos::RCP<panzer::UniqueGlobalIndexerBase> & globalIndexer,
                           const panzer::ClosureModelFactory_TemplateManager<panzer::Traits> & cm_factory,
+                          const user_app::EvaluationTypes & eval_types,
                           const Teuchos::RCP<panzer_stk::STK_Interface> & mesh,
                           const Teuchos::ParameterList & closure_model_pl,
                           const Teuchos::ParameterList & user_data)
@@ -396,8 +827,11 @@ buildSTKIOResponseLibrary(const std::vector<Teuchos::RCP<panzer::PhysicsBlock> >
                                                                                           nodalFields,
                                                                                           cellFields);
   panzer::ClosureModelFactory_TemplateManager<panzer::Traits> io_cm_factory;
+  eval_types.disableInactive(io_cm_factory);
   io_cm_factory.buildObjects(io_cm_builder);
 
+  // the library sets up its own field managers and offers no way to restrict their
+  // evaluation types, but the solution writer only registers a residual response
   stkIOResponseLibrary->buildResponseEvaluators(physicsBlocks,
                                     io_cm_factory,
                                     closure_model_pl,
@@ -425,3 +859,712 @@ void writeToExodus(const Teuchos::RCP<const Thyra::VectorBase<double> > & x,
 }
 
 
+
+void buildPhysicsModel(const std::vector<Teuchos::RCP<panzer::PhysicsBlock> > & physicsBlocks,
+                       const Teuchos::RCP<panzer_stk::STK_Interface> & mesh,
+                       const Teuchos::RCP<panzer::ConnManager<int,int> > & conn_manager,
+                       const Teuchos::RCP<const Teuchos::MpiComm<int> > & comm,
+                       const Teuchos::RCP<Teuchos::ParameterList> & lin_solver_pl,
+                       int workset_size,
+                       const Teuchos::RCP<panzer::GlobalData> & globalData,
+                       bool build_transient_support,
+                       const std::vector<panzer::BC> & bcs,
+                       const panzer::EquationSetFactory & eqset_factory,
+                       const panzer::BCStrategyFactory & bc_factory,
+                       const panzer::ClosureModelFactory_TemplateManager<panzer::Traits> & cm_factory,
+                       const user_app::EvaluationTypes & eval_types,
+                       const Teuchos::ParameterList & closure_models_pl,
+                       const Teuchos::ParameterList & user_data_pl,
+                       PhysicsModel & model)
+{
+  // build the state dof manager and LOF
+  {
+    panzer::DOFManagerFactory<int,int> globalIndexerFactory;
+    model.dofManager = globalIndexerFactory.buildUniqueGlobalIndexer(comm->getRawMpiComm(),physicsBlocks,conn_manager);
+    model.linObjFactory = Teuchos::rcp(new panzer::EpetraLinearObjFactory<panzer::Traits,int>(comm,model.dofManager));
+  }
+
+  // build worksets
+  //////////////////////////////////////////////////////////////
+    
+  // build WorksetContainer
+  Teuchos::RCP<panzer_stk::WorksetFactory> wkstFactory 
+     = Teuchos::rcp(new panzer_stk::WorksetFactory(mesh)); // build STK workset factory
+  model.wkstContainer                                       // attach it to a workset container (uses lazy evaluation)
+     = Teuchos::rcp(new panzer::WorksetContainer(wkstFactory,physicsBlocks,workset_size));
+  model.wkstContainer->setGlobalIndexer(model.dofManager);
+  std::cout << "In buildPhysicsModel(), built the workset container." << std::endl;
+
+  // build linear solver 
+  /////////////////////////////////////////////////////////////
+    
+  // preconditioners (e.g. the harmonic mean preconditioner) can ask Teko for the DOF manager
+  Teuchos::RCP<Teko::RequestHandler> req_handler = Teuchos::rcp(new Teko::RequestHandler);
+  req_handler->addRequestCallback(Teuchos::rcp(new user_app::DOFManagerRequestCallback(model.dofManager)));
+
+  model.lowsFactory
+      = panzer_stk::buildLOWSFactory(false, model.dofManager, conn_manager, 
+                                             Teuchos::as<int>(mesh->getDimension()), 
+                                             comm, lin_solver_pl,req_handler);
+  std::cout << "In buildPhysicsModel(), built the linear solver." << std::endl;
+
+  // build and setup model evaluatorlinear solver 
+  /////////////////////////////////////////////////////////////
+    
+  // the field managers are set up here rather than by setupModel(), which registers
+  // evaluators and allocates fields for every evaluation type
+  Teuchos::RCP<panzer::FieldManagerBuilder> fmb = Teuchos::rcp(new panzer::FieldManagerBuilder);
+  fmb->setActiveEvaluationTypes(eval_types.activeFlags());
+  fmb->setWorksetContainer(model.wkstContainer);
+  fmb->setupVolumeFieldManagers(physicsBlocks,cm_factory,closure_models_pl,*model.linObjFactory,user_data_pl);
+  fmb->setupBCFieldManagers(bcs,physicsBlocks,eqset_factory,cm_factory,bc_factory,closure_models_pl,
+                            *model.linObjFactory,user_data_pl);
+
+  Teuchos::RCP<panzer::ResponseLibrary<panzer::Traits> > responseLibrary
+      = Teuchos::rcp(new panzer::ResponseLibrary<panzer::Traits>(model.wkstContainer,model.dofManager,model.linObjFactory));
+
+  std::vector<Teuchos::RCP<Teuchos::Array<std::string> > > p_names;
+  std::vector<Teuchos::RCP<Teuchos::Array<double> > > p_values;
+  model.physics = Teuchos::rcp(new panzer::ModelEvaluator<double>(fmb,responseLibrary,model.linObjFactory,p_names,p_values,
+                                                                  model.lowsFactory,globalData,build_transient_support,0.0));
+}
+
+Teuchos::RCP<Teuchos::ParameterList>
+buildTimeDomainPhysicsBlocks(const Teuchos::ParameterList & physics_blocks_pl)
+{
+  Teuchos::RCP<Teuchos::ParameterList> td_physics_blocks_pl = Teuchos::rcp(new Teuchos::ParameterList(physics_blocks_pl));
+
+  std::vector<std::string> pb_names;
+  for(Teuchos::ParameterList::ConstIterator itr=td_physics_blocks_pl->begin();itr!=td_physics_blocks_pl->end();++itr)
+    pb_names.push_back(itr->first);
+
+  for(std::size_t pb=0;pb<pb_names.size();pb++) {
+    Teuchos::ParameterList & pb_pl = td_physics_blocks_pl->sublist(pb_names[pb]);
+
+    std::vector<std::string> eqset_names;
+    for(Teuchos::ParameterList::ConstIterator itr=pb_pl.begin();itr!=pb_pl.end();++itr)
+      eqset_names.push_back(itr->first);
+
+    for(std::size_t eq=0;eq<eqset_names.size();eq++) {
+      Teuchos::ParameterList & eqset_pl = pb_pl.sublist(eqset_names[eq]);
+      if(eqset_pl.get<std::string>("Type")!="FreqDom")
+        continue;
+
+      const Teuchos::ParameterList freqdom_pl = eqset_pl.sublist("FreqDom Options");
+      eqset_pl.set<std::string>("Type",freqdom_pl.get<std::string>("Time domain equation set"));
+      eqset_pl.remove("FreqDom Options");
+
+      // the nonlinear reaction term carries over to the time domain
+      if(freqdom_pl.isParameter("Nonlinear reaction coefficient") && freqdom_pl.get<double>("Nonlinear reaction coefficient")!=0.0)
+        eqset_pl.set<double>("Nonlinear reaction coefficient",freqdom_pl.get<double>("Nonlinear reaction coefficient"));
+    }
+  }
+
+  return td_physics_blocks_pl;
+}
+
+const Teuchos::ParameterList & findFreqDomEquationSet(const Teuchos::ParameterList & physics_blocks_pl)
+{
+  const Teuchos::ParameterList * eqset_pl = 0;
+  for(Teuchos::ParameterList::ConstIterator pb=physics_blocks_pl.begin();pb!=physics_blocks_pl.end() && eqset_pl==0;++pb) {
+    const Teuchos::ParameterList & pb_pl = Teuchos::getValue<Teuchos::ParameterList>(pb->second);
+    for(Teuchos::ParameterList::ConstIterator eq=pb_pl.begin();eq!=pb_pl.end() && eqset_pl==0;++eq) {
+      const Teuchos::ParameterList & candidate = Teuchos::getValue<Teuchos::ParameterList>(eq->second);
+      if(candidate.get<std::string>("Type")=="FreqDom")
+        eqset_pl = &candidate;
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(eqset_pl==0,std::runtime_error,
+                             "findFreqDomEquationSet: no \"FreqDom\" equation set in the physics blocks!");
+
+  return *eqset_pl;
+}
+
+bool hasNonlinearReaction(const Teuchos::ParameterList & physics_blocks_pl)
+{
+  for(Teuchos::ParameterList::ConstIterator pb=physics_blocks_pl.begin();pb!=physics_blocks_pl.end();++pb) {
+    const Teuchos::ParameterList & pb_pl = Teuchos::getValue<Teuchos::ParameterList>(pb->second);
+    for(Teuchos::ParameterList::ConstIterator eq=pb_pl.begin();eq!=pb_pl.end();++eq) {
+      const Teuchos::ParameterList & eqset_pl = Teuchos::getValue<Teuchos::ParameterList>(eq->second);
+      if(eqset_pl.isParameter("Nonlinear reaction coefficient") && eqset_pl.get<double>("Nonlinear reaction coefficient")!=0.0)
+        return true;
+    }
+  }
+  return false;
+}
+
+Teuchos::RCP<const user_app::HarmonicBalanceConfig>
+buildHarmonicBalanceConfig(const Teuchos::ParameterList & physics_blocks_pl)
+{
+  // the configuration fills in defaults, so work on a copy
+  Teuchos::ParameterList eqset_pl = findFreqDomEquationSet(physics_blocks_pl);
+  return Teuchos::rcp(new user_app::HarmonicBalanceConfig(eqset_pl));
+}
+
+void setTruncationOrder(Teuchos::ParameterList & physics_blocks_pl,int order)
+{
+  for(Teuchos::ParameterList::ConstIterator pb=physics_blocks_pl.begin();pb!=physics_blocks_pl.end();++pb) {
+    Teuchos::ParameterList & pb_pl = physics_blocks_pl.sublist(pb->first);
+    for(Teuchos::ParameterList::ConstIterator eq=pb_pl.begin();eq!=pb_pl.end();++eq) {
+      Teuchos::ParameterList & eqset_pl = pb_pl.sublist(eq->first);
+      if(eqset_pl.get<std::string>("Type")=="FreqDom")
+        eqset_pl.sublist("FreqDom Options").set<int>("Truncation order",order);
+    }
+  }
+}
+
+double outerHarmonicEnergyFraction(const Teuchos::ParameterList & physics_blocks_pl,
+                                   const PhysicsModel & model,
+                                   const Teuchos::RCP<const Thyra::VectorBase<double> > & solution_vec,
+                                   const PhysicsModel & td_model,
+                                   const Thyra::LinearOpBase<double> & mass)
+{
+  using Teuchos::RCP;
+
+  RCP<const user_app::HarmonicBalanceConfig> hb_config = buildHarmonicBalanceConfig(physics_blocks_pl);
+  const int truncation_order = hb_config->truncationOrder();
+  const std::vector<std::vector<int> > & harmonics = hb_config->harmonics();
+
+  // the outer shell: harmonics of this order that the next lower order does not have
+  std::vector<std::vector<int> > inner_harmonics;
+  if(truncation_order>1)
+    user_app::buildHarmonicIndexSet(hb_config->fundamentalFrequencies().size(),truncation_order-1,
+                                    hb_config->truncationScheme(),hb_config->truncationAlpha(),inner_harmonics);
+  std::set<std::vector<int> > inner(inner_harmonics.begin(),inner_harmonics.end());
+
+  RCP<const Epetra_Map> map = Teuchos::rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(model.linObjFactory,true)->getMap();
+  RCP<const Epetra_Map> td_map = Teuchos::rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(td_model.linObjFactory,true)->getMap();
+  RCP<const Epetra_Vector> x = Thyra::get_Epetra_Vector(*map,solution_vec);
+
+  // the time average of the L2 norm squared, u^T M u, of a field: it converges with the mesh,
+  // unlike the sum of squared coefficients (Dirichlet rows carry no mass and do not count)
+  RCP<Thyra::VectorBase<double> > u = Thyra::createMember(mass.domain());
+  RCP<Thyra::VectorBase<double> > mass_u = Thyra::createMember(mass.range());
+  RCP<Epetra_Vector> epetra_u = Thyra::get_Epetra_Vector(*td_map,u);
+  auto field_energy = [&](const std::string & field) {
+    user_app::copyFieldValues(*model.dofManager,field,*x,*td_model.dofManager,hb_config->meanDOFName(),*epetra_u);
+    mass.apply(Thyra::NOTRANS,*u,mass_u.ptr(),1.0,0.0);
+    return Thyra::dot(*u,*mass_u);
+  };
+
+  // Parseval: a_0^T M a_0 + sum_k (a_k^T M a_k + b_k^T M b_k)/2
+  const std::vector<std::string> & harmonic_dof_names = hb_config->harmonicDOFNames();
+  double total_energy = field_energy(hb_config->meanDOFName());
+  double outer_energy = 0.0;
+  for(std::size_t h=0;h<harmonics.size();h++) {
+    const double energy = 0.5*(field_energy(harmonic_dof_names[2*h]) + field_energy(harmonic_dof_names[2*h+1]));
+    total_energy += energy;
+    if(inner.find(harmonics[h])==inner.end())
+      outer_energy += energy;
+  }
+
+  return total_energy>0.0 ? outer_energy/total_energy : 0.0;
+}
+
+void copyCommonFields(const PhysicsModel & src_model,
+                      const Teuchos::RCP<const Thyra::VectorBase<double> > & src,
+                      const PhysicsModel & dst_model,
+                      const Teuchos::RCP<Thyra::VectorBase<double> > & dst)
+{
+  using Teuchos::RCP;
+
+  RCP<const Epetra_Map> src_map = Teuchos::rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(src_model.linObjFactory,true)->getMap();
+  RCP<const Epetra_Map> dst_map = Teuchos::rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(dst_model.linObjFactory,true)->getMap();
+  RCP<const Epetra_Vector> epetra_src = Thyra::get_Epetra_Vector(*src_map,src);
+  RCP<Epetra_Vector> epetra_dst = Thyra::get_Epetra_Vector(*dst_map,dst);
+
+  for(int field=0;field<src_model.dofManager->getNumFields();field++) {
+    const std::string & field_name = src_model.dofManager->getFieldString(field);
+    if(dst_model.dofManager->getFieldNum(field_name)<0)
+      continue;
+
+    user_app::copyFieldValues(*src_model.dofManager,field_name,*epetra_src,
+                              *dst_model.dofManager,field_name,*epetra_dst);
+  }
+}
+
+void buildHarmonicCoupling(const Teuchos::ParameterList & physics_blocks_pl,
+                           std::string & td_dof_name,
+                           std::vector<std::string> & hb_dof_names,
+                           Teuchos::SerialDenseMatrix<int,double> & coupling)
+{
+  Teuchos::RCP<const user_app::HarmonicBalanceConfig> hb_config = buildHarmonicBalanceConfig(physics_blocks_pl);
+
+  // same naming as EquationSet_FreqDom
+  td_dof_name  = hb_config->meanDOFName();
+  hb_dof_names = hb_config->dofNames();
+
+  coupling.shape(hb_dof_names.size(),hb_dof_names.size());
+  for(std::size_t h=0;h<hb_config->harmonics().size();h++) {
+    const double omega = 2.0*M_PI*hb_config->harmonicDOFFrequencies()[2*h];
+    const int c = 2*h+1, s = 2*h+2;
+    coupling(c,s) =  omega;
+    coupling(s,c) = -omega;
+  }
+}
+
+void assembleMassAndStiffness(const panzer::ModelEvaluator<double> & td_physics,
+                              Teuchos::RCP<Thyra::VectorBase<double> > & f0,
+                              Teuchos::RCP<Thyra::LinearOpBase<double> > & mass,
+                              Teuchos::RCP<Thyra::LinearOpBase<double> > & stiffness)
+{
+  using Teuchos::RCP;
+
+  // assemble the mass and stiffness matrices once, W = alpha M + beta K
+  /////////////////////////////////////////////////////////////
+  RCP<Thyra::VectorBase<double> > x = Thyra::createMember(td_physics.get_x_space());
+  RCP<Thyra::VectorBase<double> > x_dot = Thyra::createMember(td_physics.get_x_space());
+  Thyra::assign(x.ptr(),0.0);
+  Thyra::assign(x_dot.ptr(),0.0);
+
+  f0 = Thyra::createMember(td_physics.get_f_space());
+  mass = td_physics.create_W_op();
+  stiffness = td_physics.create_W_op();
+  {
+    Thyra::ModelEvaluatorBase::InArgs<double> inArgs = td_physics.createInArgs();
+    inArgs.set_x(x);
+    inArgs.set_x_dot(x_dot);
+    inArgs.set_alpha(1.0);
+    inArgs.set_beta(0.0);
+
+    Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = td_physics.createOutArgs();
+    outArgs.set_f(f0);
+    outArgs.set_W_op(mass);
+
+    td_physics.evalModel(inArgs,outArgs);
+  }
+  {
+    Thyra::ModelEvaluatorBase::InArgs<double> inArgs = td_physics.createInArgs();
+    inArgs.set_x(x);
+    inArgs.set_x_dot(x_dot);
+    inArgs.set_alpha(0.0);
+    inArgs.set_beta(1.0);
+
+    Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = td_physics.createOutArgs();
+    outArgs.set_W_op(stiffness);
+
+    td_physics.evalModel(inArgs,outArgs);
+  }
+}
+
+void solveKronecker(const PhysicsModel & td_model,
+                    const std::string & td_dof_name,
+                    const PhysicsModel & hb_model,
+                    const std::vector<std::string> & hb_dof_names,
+                    const Teuchos::SerialDenseMatrix<int,double> & coupling,
+                    const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+  using Teuchos::rcp_dynamic_cast;
+
+  RCP<Thyra::VectorBase<double> > f0;
+  RCP<Thyra::LinearOpBase<double> > mass, stiffness;
+  assembleMassAndStiffness(*td_model.physics,f0,mass,stiffness);
+  std::cout << "In solveKronecker(), assembled the mass and stiffness matrices." << std::endl;
+
+  // solve J x = F(0); the source is steady, so only the 0th mode has a right hand side
+  /////////////////////////////////////////////////////////////
+  RCP<user_app::HarmonicKroneckerOp> hb_op = rcp(new user_app::HarmonicKroneckerOp(stiffness,mass,coupling));
+
+  RCP<Thyra::VectorBase<double> > rhs = Thyra::createMember(hb_op->range());
+  Thyra::assign(rhs.ptr(),0.0);
+  Thyra::assign(Thyra::nonconstProductVectorBase<double>(rhs)->getNonconstVectorBlock(0).ptr(),*f0);
+
+  RCP<Thyra::VectorBase<double> > hb_x = Thyra::createMember(hb_op->domain());
+  Thyra::assign(hb_x.ptr(),0.0);
+
+  RCP<Thyra::LinearOpWithSolveBase<double> > lows = Thyra::linearOpWithSolve<double>(*td_model.lowsFactory,hb_op);
+  lows->solve(Thyra::NOTRANS,*rhs,hb_x.ptr());
+
+  // move the harmonics into the harmonic balance DOF layout
+  /////////////////////////////////////////////////////////////
+  RCP<const Epetra_Map> td_map = rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(td_model.linObjFactory,true)->getMap();
+  RCP<const Epetra_Map> hb_map = rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(hb_model.linObjFactory,true)->getMap();
+
+  RCP<const Thyra::ProductVectorBase<double> > prod_x = Thyra::productVectorBase<double>(hb_x.getConst());
+  RCP<Epetra_Vector> epetra_solution = Thyra::get_Epetra_Vector(*hb_map,solution_vec);
+  for(std::size_t i=0;i<hb_dof_names.size();i++) {
+    RCP<const Epetra_Vector> harmonic = Thyra::get_Epetra_Vector(*td_map,prod_x->getVectorBlock(i));
+    user_app::copyFieldValues(*td_model.dofManager,td_dof_name,*harmonic,
+                              *hb_model.dofManager,hb_dof_names[i],*epetra_solution);
+  }
+}
+
+void solveComplexHarmonics(const PhysicsModel & td_model,
+                           const user_app::HarmonicBalanceConfig & hb_config,
+                           const Teuchos::RCP<const Teuchos::Comm<int> > & comm,
+                           const Teuchos::ParameterList & complex_solver_pl,
+                           const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec,
+                           panzer_stk::STK_Interface & mesh)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp_dynamic_cast;
+
+  const panzer::ModelEvaluator<double> & td_physics = *td_model.physics;
+  const std::string & td_dof_name = hb_config.meanDOFName();
+  const std::vector<std::string> & harmonic_dof_names = hb_config.harmonicDOFNames();
+  const std::vector<double> & harmonic_frequencies = hb_config.harmonicDOFFrequencies();
+
+  RCP<Thyra::VectorBase<double> > f0;
+  RCP<Thyra::LinearOpBase<double> > mass, stiffness;
+  assembleMassAndStiffness(td_physics,f0,mass,stiffness);
+  std::cout << "In solveComplexHarmonics(), assembled the mass and stiffness matrices." << std::endl;
+
+  // the right hand sides are the harmonics of the source part of the residual, f(0,0,t) = -b(t),
+  // sampled over a period of the lowest harmonic with the rectangle rule; a source that does not
+  // depend on t samples the same every time and only drives the 0th mode
+  /////////////////////////////////////////////////////////////
+  const int num_samples = hb_config.aftTimeSamples();
+  // combination harmonics of several fundamental frequencies can have a negative frequency
+  double frequency_min = 0.0;
+  for(std::size_t i=0;i<harmonic_frequencies.size();i++)
+    if(harmonic_frequencies[i]!=0.0 && (frequency_min==0.0 || std::fabs(harmonic_frequencies[i])<frequency_min))
+      frequency_min = std::fabs(harmonic_frequencies[i]);
+  const double period = frequency_min>0.0 ? 1.0/frequency_min : 0.0;
+
+  RCP<Thyra::VectorBase<double> > x = Thyra::createMember(td_physics.get_x_space());
+  RCP<Thyra::VectorBase<double> > f = Thyra::createMember(td_physics.get_f_space());
+  Thyra::assign(x.ptr(),0.0);
+
+  // r[0] = <f>, r[1+2h] = 2<f cos>, r[2+2h] = 2<f sin> of harmonic h
+  std::vector<RCP<Thyra::VectorBase<double> > > r(harmonic_dof_names.size()+1);
+  for(std::size_t i=0;i<r.size();i++) {
+    r[i] = Thyra::createMember(td_physics.get_f_space());
+    Thyra::assign(r[i].ptr(),0.0);
+  }
+  // f0 is the t = 0 sample, where cos is 1 and sin is 0
+  Thyra::Vp_StV(r[0].ptr(),1.0/num_samples,*f0);
+  for(std::size_t i=0;i<harmonic_dof_names.size();i+=2)
+    Thyra::Vp_StV(r[i+1].ptr(),2.0/num_samples,*f0);
+
+  bool steady = true;
+  for(int j=1;j<num_samples && period>0.0;j++) {
+    const double t = j*period/num_samples;
+
+    Thyra::ModelEvaluatorBase::InArgs<double> inArgs = td_physics.createInArgs();
+    inArgs.set_x(x);
+    inArgs.set_x_dot(x);
+    inArgs.set_t(t);
+
+    Thyra::ModelEvaluatorBase::OutArgs<double> outArgs = td_physics.createOutArgs();
+    outArgs.set_f(f);
+
+    td_physics.evalModel(inArgs,outArgs);
+
+    Thyra::Vp_StV(r[0].ptr(),1.0/num_samples,*f);
+    for(std::size_t i=0;i<harmonic_dof_names.size();i+=2) {
+      const double omega = 2.0*M_PI*harmonic_frequencies[i];
+      Thyra::Vp_StV(r[i+1].ptr(),2.0*std::cos(omega*t)/num_samples,*f);
+      Thyra::Vp_StV(r[i+2].ptr(),2.0*std::sin(omega*t)/num_samples,*f);
+    }
+
+    Thyra::Vp_StV(f.ptr(),-1.0,*f0);
+    steady = steady && Thyra::norm_inf(*f)==0.0;
+  }
+  if(steady)
+    Thyra::assign(r[0].ptr(),*f0);
+  else {
+    // the rectangle rule only separates harmonics of one common period
+    for(std::size_t i=0;i<harmonic_frequencies.size();i++) {
+      const double multiple = std::fabs(harmonic_frequencies[i])/frequency_min;
+      TEUCHOS_TEST_FOR_EXCEPTION(std::fabs(multiple-std::floor(multiple+0.5))>1.0e-12*multiple,std::runtime_error,
+                                 "solveComplexHarmonics: a time dependent source needs harmonics of a single fundamental frequency!");
+    }
+  }
+
+  RCP<const Epetra_Map> td_map = rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(td_model.linObjFactory,true)->getMap();
+
+  user_app::ComplexHarmonicSolver solver(rcp_dynamic_cast<const Epetra_CrsMatrix>(Thyra::get_Epetra_Operator(*stiffness),true),
+                                         rcp_dynamic_cast<const Epetra_CrsMatrix>(Thyra::get_Epetra_Operator(*mass),true),
+                                         comm,complex_solver_pl);
+
+  Epetra_Vector b_re(*td_map), b_im(*td_map), x_re(*td_map), x_im(*td_map);
+
+  // the 0th mode is real: K a_0 = -<f>
+  /////////////////////////////////////////////////////////////
+  b_re.Update(-1.0,*Thyra::get_Epetra_Vector(*td_map,r[0].getConst()),0.0);
+  solver.solve(0.0,b_re,b_im,x_re,x_im);
+  *Thyra::get_Epetra_Vector(*td_map,solution_vec) = x_re;
+
+  // each harmonic is one complex coefficient c = a - i b with (K + i omega M) c = -(r_c - i r_s);
+  // without a right hand side it is zero and needs no solve
+  /////////////////////////////////////////////////////////////
+  int num_solves = 0;
+  for(std::size_t i=0;i<harmonic_dof_names.size();i+=2) {
+    x_re.PutScalar(0.0);
+    x_im.PutScalar(0.0);
+    if(!steady) {
+      b_re.Update(-1.0,*Thyra::get_Epetra_Vector(*td_map,r[i+1].getConst()),0.0);
+      b_im.Update( 1.0,*Thyra::get_Epetra_Vector(*td_map,r[i+2].getConst()),0.0);
+      solver.solve(2.0*M_PI*harmonic_frequencies[i],b_re,b_im,x_re,x_im);
+      x_im.Scale(-1.0);
+      num_solves++;
+    }
+
+    user_app::writeFieldToMesh(*td_model.dofManager,td_dof_name,x_re,harmonic_dof_names[i],mesh);
+    user_app::writeFieldToMesh(*td_model.dofManager,td_dof_name,x_im,harmonic_dof_names[i+1],mesh);
+  }
+  std::cout << "In solveComplexHarmonics(), solved " << num_solves << " of " << harmonic_dof_names.size()/2 << " harmonics";
+  if(steady)
+    std::cout << ", the source does not depend on t so the others have no right hand side";
+  std::cout << std::endl;
+}
+
+void transientInitialGuess(const PhysicsModel & td_model,
+                           const std::string & td_dof_name,
+                           const PhysicsModel & hb_model,
+                           const std::vector<std::string> & hb_dof_names,
+                           const Teuchos::SerialDenseMatrix<int,double> & coupling,
+                           const Teuchos::ParameterList & transient_pl,
+                           const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp_dynamic_cast;
+
+  const panzer::ModelEvaluator<double> & td_physics = *td_model.physics;
+
+  const int periods          = transient_pl.isParameter("Periods") ? transient_pl.get<int>("Periods") : 4;
+  const int steps_per_period = transient_pl.isParameter("Steps Per Period") ? transient_pl.get<int>("Steps Per Period") : 32;
+  const int max_iterations   = transient_pl.isParameter("Newton Max Iterations") ? transient_pl.get<int>("Newton Max Iterations") : 10;
+  const double tolerance     = transient_pl.isParameter("Newton Tolerance") ? transient_pl.get<double>("Newton Tolerance") : 1.0e-8;
+
+  // the period of the lowest harmonic; with a single fundamental frequency it is the period of all of them
+  double omega_min = 0.0;
+  for(std::size_t c=1;c+1<hb_dof_names.size();c+=2)
+    if(omega_min==0.0 || std::fabs(coupling(c,c+1))<omega_min)
+      omega_min = std::fabs(coupling(c,c+1));
+  TEUCHOS_TEST_FOR_EXCEPTION(omega_min==0.0,std::runtime_error,
+                             "transientInitialGuess: the FreqDom equation set has no harmonics to project onto!");
+  const double period = 2.0*M_PI/omega_min;
+  const double dt = period/steps_per_period;
+
+  // backward Euler, reusing W and its solver from step to step
+  user_app::BDFIntegrator integrator(td_model.physics,td_model.lowsFactory,1);
+  integrator.setNewtonTolerance(tolerance,max_iterations);
+  {
+    RCP<Thyra::VectorBase<double> > x0 = Thyra::createMember(td_physics.get_x_space());
+    Thyra::assign(x0.ptr(),0.0);
+    integrator.initialize(*x0,0.0);
+  }
+
+  // running projections onto 1, cos and sin over the last period
+  std::vector<RCP<Thyra::VectorBase<double> > > coefficients(hb_dof_names.size());
+  for(std::size_t i=0;i<coefficients.size();i++) {
+    coefficients[i] = Thyra::createMember(td_physics.get_x_space());
+    Thyra::assign(coefficients[i].ptr(),0.0);
+  }
+
+  const int num_steps = periods*steps_per_period;
+  for(int step=1;step<=num_steps;step++) {
+    integrator.step(dt);
+
+    // rectangle rule over the last period: a_0 = <u>, a_k = 2<u cos>, b_k = 2<u sin>
+    if(step>num_steps-steps_per_period) {
+      const Thyra::VectorBase<double> & x = *integrator.getSolution();
+      const double t = integrator.getTime();
+      Thyra::Vp_StV(coefficients[0].ptr(),1.0/steps_per_period,x);
+      for(std::size_t c=1;c+1<hb_dof_names.size();c+=2) {
+        const double omega = coupling(c,c+1);
+        Thyra::Vp_StV(coefficients[c].ptr(),2.0*std::cos(omega*t)/steps_per_period,x);
+        Thyra::Vp_StV(coefficients[c+1].ptr(),2.0*std::sin(omega*t)/steps_per_period,x);
+      }
+    }
+  }
+  std::cout << "In transientInitialGuess(), integrated " << periods << " period(s) of "
+            << steps_per_period << " steps with dt = " << dt << ", " << integrator.numNewtonIterations()
+            << " Newton iterations and " << integrator.numSolverBuilds() << " build(s) of W" << std::endl;
+
+  // move the harmonics into the harmonic balance DOF layout
+  /////////////////////////////////////////////////////////////
+  RCP<const Epetra_Map> td_map = rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(td_model.linObjFactory,true)->getMap();
+  RCP<const Epetra_Map> hb_map = rcp_dynamic_cast<panzer::EpetraLinearObjFactory<panzer::Traits,int> >(hb_model.linObjFactory,true)->getMap();
+
+  RCP<Epetra_Vector> epetra_solution = Thyra::get_Epetra_Vector(*hb_map,solution_vec);
+  for(std::size_t i=0;i<hb_dof_names.size();i++) {
+    RCP<const Epetra_Vector> harmonic = Thyra::get_Epetra_Vector(*td_map,coefficients[i].getConst());
+    user_app::copyFieldValues(*td_model.dofManager,td_dof_name,*harmonic,
+                              *hb_model.dofManager,hb_dof_names[i],*epetra_solution);
+  }
+}
+
+void integrateTransient(const PhysicsModel & model,
+                        const Teuchos::ParameterList & transient_pl,
+                        const Teuchos::RCP<const Teuchos::Comm<int> > & time_comm,
+                        const Teuchos::RCP<Thyra::VectorBase<double> > & solution_vec)
+{
+  const std::string scheme   = transient_pl.isParameter("Scheme") ? transient_pl.get<std::string>("Scheme") : "BDF2";
+  const double final_time    = transient_pl.isParameter("Final Time") ? transient_pl.get<double>("Final Time") : 1.0;
+  const int max_iterations   = transient_pl.isParameter("Newton Max Iterations") ? transient_pl.get<int>("Newton Max Iterations") : 10;
+  const double tolerance     = transient_pl.isParameter("Newton Tolerance") ? transient_pl.get<double>("Newton Tolerance") : 1.0e-8;
+  TEUCHOS_TEST_FOR_EXCEPTION(scheme!="BDF1" && scheme!="BDF2" && scheme!="Exponential",std::runtime_error,
+                             "Unknown transient \"Scheme\" = \"" << scheme << "\", choose \"BDF1\", \"BDF2\" or \"Exponential\".");
+  TEUCHOS_TEST_FOR_EXCEPTION(final_time<=0.0,std::runtime_error,
+                             "integrateTransient: \"Final Time\" must be positive!");
+
+  if(scheme=="Exponential") {
+    // "Time Step" is the interval between the output times, the step itself has no stability
+    // limit and, for a source that does not change in time, no error beyond the Krylov tolerance
+    const double time_step   = transient_pl.isParameter("Time Step") ? transient_pl.get<double>("Time Step") : 0.01;
+    const double shift       = transient_pl.isParameter("Krylov Shift") ? transient_pl.get<double>("Krylov Shift") : 0.1*time_step;
+    const double krylov_tol  = transient_pl.isParameter("Krylov Tolerance") ? transient_pl.get<double>("Krylov Tolerance") : 1.0e-8;
+    const int krylov_dim     = transient_pl.isParameter("Krylov Dimension") ? transient_pl.get<int>("Krylov Dimension") : 30;
+    const bool adaptive      = transient_pl.isParameter("Adaptive Time Step") ? transient_pl.get<bool>("Adaptive Time Step") : false;
+    TEUCHOS_TEST_FOR_EXCEPTION(time_step<=0.0,std::runtime_error,
+                               "integrateTransient: \"Time Step\" must be positive!");
+    TEUCHOS_TEST_FOR_EXCEPTION(adaptive || time_comm!=Teuchos::null,std::runtime_error,
+                               "integrateTransient: the \"Exponential\" scheme takes neither adaptive steps nor Parareal.");
+
+    user_app::KrylovExponentialIntegrator integrator(model.physics,model.lowsFactory,shift);
+    integrator.setTolerance(krylov_tol,krylov_dim);
+    integrator.initialize(*solution_vec,0.0);
+
+    const int num_steps = std::max(1,int(std::ceil(final_time/time_step-1.0e-10)));
+    const double dt = final_time/num_steps;
+    for(int step=1;step<=num_steps;step++) {
+      integrator.step(dt);
+      std::cout << "Time step " << step << ": t = " << integrator.getTime()
+                << ", ||u|| = " << Thyra::norm_2(*integrator.getSolution()) << std::endl;
+    }
+    std::cout << "In integrateTransient(), Exponential took " << num_steps << " steps with dt = " << dt
+              << " and " << integrator.numKrylovIterations() << " Krylov iterations" << std::endl;
+
+    Thyra::assign(solution_vec.ptr(),*integrator.getSolution());
+    return;
+  }
+
+  user_app::BDFIntegrator integrator(model.physics,model.lowsFactory,scheme=="BDF1" ? 1 : 2);
+  integrator.setNewtonTolerance(tolerance,max_iterations);
+
+  if(time_comm==Teuchos::null) {
+    integrator.initialize(*solution_vec,0.0);
+    const int rejected = advanceTransient(integrator,transient_pl,final_time,true);
+
+    std::cout << "In integrateTransient(), " << scheme << " took " << integrator.numSteps() << " steps";
+    if(rejected>0)
+      std::cout << " (and rejected " << rejected << ")";
+    std::cout << ", " << integrator.numNewtonIterations() << " Newton iterations and "
+              << integrator.numSolverBuilds() << " build(s) of W and its solver" << std::endl;
+
+    Thyra::assign(solution_vec.ptr(),*integrator.getSolution());
+    return;
+  }
+
+  // Parareal: the fine propagator is the time integration above, the coarse one is backward
+  // Euler with "Parareal Coarse Time Step", one step per slice by default. Both keep their W
+  // from one slice propagation to the next.
+  const int num_slices       = time_comm->getSize();
+  const double coarse_step   = transient_pl.isParameter("Parareal Coarse Time Step")
+                               ? transient_pl.get<double>("Parareal Coarse Time Step") : final_time/num_slices;
+  const double pr_tolerance  = transient_pl.isParameter("Parareal Tolerance") ? transient_pl.get<double>("Parareal Tolerance") : 1.0e-8;
+  const int pr_iterations    = transient_pl.isParameter("Parareal Max Iterations") ? transient_pl.get<int>("Parareal Max Iterations") : num_slices;
+
+  user_app::BDFIntegrator coarse(model.physics,model.lowsFactory,1);
+  coarse.setNewtonTolerance(tolerance,max_iterations);
+
+  user_app::Parareal parareal(time_comm,model.physics->get_x_space(),
+      [&](const Thyra::VectorBase<double> & x0,double t0,double t1,const Teuchos::Ptr<Thyra::VectorBase<double> > & x1) {
+        const int num_steps = std::max(1,int(std::ceil((t1-t0)/coarse_step-1.0e-10)));
+        coarse.initialize(x0,t0);
+        for(int step=0;step<num_steps;step++)
+          coarse.step((t1-t0)/num_steps);
+        Thyra::assign(x1,*coarse.getSolution());
+      },
+      [&](const Thyra::VectorBase<double> & x0,double t0,double t1,const Teuchos::Ptr<Thyra::VectorBase<double> > & x1) {
+        integrator.initialize(x0,t0);
+        advanceTransient(integrator,transient_pl,t1,false);
+        Thyra::assign(x1,*integrator.getSolution());
+      });
+  parareal.setTolerance(pr_tolerance,pr_iterations);
+
+  Teuchos::RCP<const Thyra::VectorBase<double> > x0 = solution_vec->clone_v();
+  parareal.integrate(*x0,0.0,final_time,solution_vec.ptr());
+
+  std::cout << "In integrateTransient(), Parareal over " << num_slices << " slices took " << parareal.numIterations()
+            << " iterations; slice " << time_comm->getRank() << " ran " << parareal.numFineSolves() << " fine propagations of "
+            << scheme << " in " << integrator.numSteps() << " steps with " << integrator.numSolverBuilds()
+            << " build(s) of W, and " << coarse.numSteps() << " coarse steps" << std::endl;
+}
+
+int advanceTransient(user_app::BDFIntegrator & integrator,
+                     const Teuchos::ParameterList & transient_pl,
+                     double final_time,
+                     bool verbose)
+{
+  const double time_step     = transient_pl.isParameter("Time Step") ? transient_pl.get<double>("Time Step") : 0.01;
+  // with an adaptive step "Time Step" is the first step
+  const bool adaptive        = transient_pl.isParameter("Adaptive Time Step") ? transient_pl.get<bool>("Adaptive Time Step") : false;
+  TEUCHOS_TEST_FOR_EXCEPTION(time_step<=0.0,std::runtime_error,
+                             "advanceTransient: \"Time Step\" must be positive!");
+
+  if(!adaptive) {
+    // equal steps that end on the final time, so one W serves every step
+    const double interval = final_time-integrator.getTime();
+    const int num_steps = std::max(1,int(std::ceil(interval/time_step-1.0e-10)));
+    const double dt = interval/num_steps;
+
+    for(int step=1;step<=num_steps;step++) {
+      integrator.step(dt);
+      if(verbose)
+        std::cout << "Time step " << step << ": t = " << integrator.getTime()
+                  << ", ||u|| = " << Thyra::norm_2(*integrator.getSolution()) << std::endl;
+    }
+    return 0;
+  }
+
+  const double abs_tolerance = transient_pl.isParameter("Absolute Tolerance") ? transient_pl.get<double>("Absolute Tolerance") : 1.0e-6;
+  const double rel_tolerance = transient_pl.isParameter("Relative Tolerance") ? transient_pl.get<double>("Relative Tolerance") : 1.0e-4;
+  const double min_step      = transient_pl.isParameter("Min Time Step") ? transient_pl.get<double>("Min Time Step") : 1.0e-10;
+  const double reuse_ratio   = transient_pl.isParameter("W Reuse Ratio") ? transient_pl.get<double>("W Reuse Ratio") : 1.5;
+  Teuchos::Array<double> gains(3);
+  gains[0] = 0.075; gains[1] = 0.175; gains[2] = 0.01;
+  if(transient_pl.isParameter("PID Gains"))
+    gains = transient_pl.get<Teuchos::Array<double> >("PID Gains");
+  TEUCHOS_TEST_FOR_EXCEPTION(gains.size()!=3,std::runtime_error,
+                             "advanceTransient: \"PID Gains\" needs the three gains {kP,kI,kD}!");
+
+  user_app::PIDStepController controller(gains[0],gains[1],gains[2]);
+  controller.setLimits(transient_pl.isParameter("Safety Factor") ? transient_pl.get<double>("Safety Factor") : 0.9,
+                       transient_pl.isParameter("Min Step Factor") ? transient_pl.get<double>("Min Step Factor") : 0.2,
+                       transient_pl.isParameter("Max Step Factor") ? transient_pl.get<double>("Max Step Factor") : 5.0);
+
+  // small changes of dt run on the W of the old step, its chord iterations converge all the same
+  integrator.setSolverReuseRatio(reuse_ratio);
+  integrator.setErrorControl(true);
+
+  int rejected = 0;
+  double dt = time_step;
+  for(bool done=false;!done;) {
+    // land on the final time, without leaving a sliver of a step
+    const double remaining = final_time-integrator.getTime();
+    const bool last = (1.1*dt>=remaining);
+    const double trial = last ? remaining : dt;
+    TEUCHOS_TEST_FOR_EXCEPTION(trial<min_step && !last,std::runtime_error,
+                               "advanceTransient: the step " << trial << " fell below \"Min Time Step\" at t = "
+                               << integrator.getTime());
+
+    if(!integrator.solveStep(trial)) {
+      dt = 0.5*trial;
+      rejected++;
+      continue;
+    }
+
+    // the first step has no history to estimate its error from and is taken as is
+    const double error = integrator.errorEstimate(abs_tolerance,rel_tolerance);
+    if(error>1.0) {
+      dt = controller.rejectedStep(trial,error,integrator.stepOrder());
+      rejected++;
+      continue;
+    }
+
+    integrator.acceptStep();
+    done = last;
+    if(error>=0.0)
+      dt = controller.acceptedStep(trial,error);
+    if(verbose)
+      std::cout << "Time step " << integrator.numSteps() << ": t = " << integrator.getTime() << ", dt = " << trial
+                << ", error = " << error << ", ||u|| = " << Thyra::norm_2(*integrator.getSolution()) << std::endl;
+  }
+
+  return rejected;
+}